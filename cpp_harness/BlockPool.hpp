@@ -9,8 +9,11 @@
 #include <sys/mman.h>
 #include <assert.h>
 #include <malloc.h>
+#include <unistd.h>
+#include <atomic>
 #include "ConcurrentPrimitives.hpp"
 #include "RAllocator.hpp"
+#include "HarnessUtils.hpp"
 
 //////////////////////////////
 //
@@ -59,10 +62,19 @@ class BlockPool : public RAllocator
 	// number of threads
 	int num_threads;
 
+	// arena mode: every block comes from one contiguous reservation, so a
+	// block can also be named by a 32-bit index (see indexOf/fromIndex)
+	struct shared_block_t* arena_base;
+	unsigned long arena_blocks;
+	std::atomic<unsigned long> arena_next;
+
     // add and remove blocks from/to global pool in clumps of this size
     static const unsigned long GROUP_SIZE = 8;
 
-    static const int blocksize = sizeof(shared_block_t);
+    // bytes per block: the block header and payload, plus any extra bytes
+    // the payload runs into (e.g. a trailing variable-length array)
+    unsigned long blocksize;
+    unsigned long extra_bytes;
 
     // [?] why don't we make this a static member, align it, make it volatile,
     // and then pass its address to CAS?
@@ -83,6 +95,13 @@ class BlockPool : public RAllocator
                                   ((unsigned char*)&(dum.payload) - (unsigned char*)&dum));
     }
 
+    // blocks are blocksize apart, which is more than sizeof(shared_block_t)
+    // when the pool carries extra bytes
+    inline shared_block_t* block_at(shared_block_t* base, unsigned long i)
+    {
+        return (shared_block_t*) (((unsigned char*)base) + i * blocksize);
+    }
+
 public:
 
 	// make sure nothing else is in the same line as this object
@@ -94,9 +113,28 @@ public:
     //  by a specified number of threads.  Return value is an opaque pointer.  This
     //  routine must be called by one thread only.
     //
-    BlockPool<T>(int _numthreads, bool _glibc_mem){
-		glibc_mem = _glibc_mem;
+    //  If _arena_blocks is nonzero, reserve address space for that many blocks
+    //  up front and carve all blocks from it (glibc mode is ignored).
+    //
+    //  _extra_bytes are added to the end of every payload, for payload types
+    //  whose last member is a variable-length array.
+    //
+    BlockPool<T>(int _numthreads, bool _glibc_mem, unsigned long _arena_blocks = 0, unsigned long _extra_bytes = 0){
+		glibc_mem = _glibc_mem && _arena_blocks == 0;
 		num_threads = _numthreads;
+		extra_bytes = _extra_bytes;
+		blocksize = (sizeof(shared_block_t) + extra_bytes + alignof(shared_block_t) - 1) & ~(alignof(shared_block_t) - 1);
+		arena_base = NULL;
+		arena_blocks = _arena_blocks;
+		arena_next.store(1); // index 0 stands for NULL
+		if(arena_blocks != 0){
+			// reserve only; groups are made accessible as they are handed out
+			void* mem = mmap(0, arena_blocks * blocksize, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+			if(mem == MAP_FAILED){
+				errexit("BlockPool could not reserve its arena.");
+			}
+			arena_base = (shared_block_t*)mem;
+		}
 		if(glibc_mem){
 			//puts("glibc");
 			return;
@@ -126,15 +164,34 @@ public:
 
 	// NOTE doesn't automatically pad allocations anymore
 	void appendBlockGroup(block_head_node_t* hn){
-		shared_block_t* array = (shared_block_t*)memalign(LEVEL1_DCACHE_LINESIZE, blocksize*GROUP_SIZE);
-		assert(array);
+		shared_block_t* array;
+		if(arena_base){
+			unsigned long first = arena_next.fetch_add(GROUP_SIZE);
+			if(first + GROUP_SIZE > arena_blocks){
+				errexit("BlockPool arena exhausted.");
+			}
+			array = block_at(arena_base, first);
+			// open up the pages covering this group
+			uintptr_t page = sysconf(_SC_PAGESIZE);
+			uintptr_t lo = (uintptr_t)array & ~(page-1);
+			uintptr_t hi = ((uintptr_t)block_at(array, GROUP_SIZE) + page-1) & ~(page-1);
+			if(mprotect((void*)lo, hi-lo, PROT_READ | PROT_WRITE) != 0){
+				errexit("BlockPool could not map arena pages.");
+			}
+		}
+		else{
+			array = (shared_block_t*)memalign(LEVEL1_DCACHE_LINESIZE, blocksize*GROUP_SIZE);
+			if(!array){
+				errexit("BlockPool out of memory.");
+			}
+		}
 		memset (array,0,blocksize*GROUP_SIZE);
-		hn->top = &array[0];
+		hn->top = array;
 		hn->nth = hn->top;
 		hn->count = GROUP_SIZE;
-		array[GROUP_SIZE-1].next=NULL;
+		block_at(array, GROUP_SIZE-1)->next=NULL;
 		for(int i = 0; i<GROUP_SIZE-1;i++){
-			array[i].next=&array[i+1];
+			block_at(array, i)->next=block_at(array, i+1);
 		}
 	} 
 
@@ -142,7 +199,7 @@ public:
     T* alloc(int tid){
 
 		if(glibc_mem){
-			return (T*)memalign(sizeof(T),1<<((int)log2(sizeof(T)))+2);
+			return (T*)memalign(sizeof(T),(1<<((int)log2(sizeof(T))+2)) + extra_bytes);
 		}
         block_head_node_t* hn = &head_nodes[tid];
         shared_block_t* b = hn->top;
@@ -222,6 +279,16 @@ public:
         }
     }
 
+	// arena mode only: 32-bit name of a block and back (0 is NULL)
+	uint32_t indexOf(T* block){
+		if(block==NULL){return 0;}
+		return (uint32_t)(((unsigned char*)make_shared_block_t(block) - (unsigned char*)arena_base) / blocksize);
+	}
+	T* fromIndex(uint32_t index){
+		if(index==0){return NULL;}
+		return (T*)&block_at(arena_base, index)->payload;
+	}
+
 	// for Rideable interface
 	void* allocBlock(int tid){
 		return alloc(tid);
@@ -230,7 +297,7 @@ public:
 		free((T*)ptr, tid);
 	}
 	BlockPool<T>* clone(){
-		return new BlockPool<T>(num_threads,glibc_mem);
+		return new BlockPool<T>(num_threads,glibc_mem,arena_blocks,extra_bytes);
 	}
 
 	void preheat(int quantity){
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <atomic>
 #include <string>
+#include <stdint.h>
+#include <string.h>
 
 #ifndef LEVEL1_DCACHE_LINESIZE
 #define LEVEL1_DCACHE_LINESIZE 128
@@ -84,7 +86,90 @@ public:
 
 
 
+#if UINTPTR_MAX > 0xffffffffu
+// Double-width atomic for counted values (64-bit builds only).
+// The whole value is updated with a single cmpxchg16b (build with -mcx16).
+// Loads avoid the locked instruction by reading both words and checking
+// that the second word did not change in between, so the second word of T
+// must change on every successful update (e.g. it carries a sequence
+// number).  store() is only safe on values no other thread can see yet.
+template<typename T>
+class wideAtomic {
+	static_assert(sizeof(T) == 2 * sizeof(uint64_t), "wideAtomic requires a 16 byte type");
+
+	volatile uint64_t ui[2] __attribute__(( aligned(16) ));
+
+	static unsigned __int128 pack(const T &val) {
+		unsigned __int128 r;
+		memcpy(&r, &val, sizeof(r));
+		return r;
+	}
+
+	static T unpack(const uint64_t *w) {
+		T r;
+		memcpy(&r, w, sizeof(r));
+		return r;
+	}
+
+public:
+	wideAtomic<T> () { }
+
+	T load(std::memory_order order = std::memory_order_seq_cst) const {
+		uint64_t w[2];
+		for (;;) {
+			w[1] = __atomic_load_n(&ui[1], __ATOMIC_ACQUIRE);
+			w[0] = __atomic_load_n(&ui[0], __ATOMIC_ACQUIRE);
+			if (w[1] == __atomic_load_n(&ui[1], __ATOMIC_RELAXED)) {
+				return unpack(w);
+			}
+		}
+	}
+
+	void store(const T &val, std::memory_order order = std::memory_order_seq_cst) {
+		uint64_t w[2];
+		memcpy(w, &val, sizeof(w));
+		__atomic_store_n(&ui[0], w[0], __ATOMIC_RELAXED);
+		__atomic_store_n(&ui[1], w[1], __ATOMIC_RELEASE);
+	}
+
+	bool compare_exchange_strong(T &exp, const T &des,
+		std::memory_order succ = std::memory_order_seq_cst, std::memory_order fail = std::memory_order_seq_cst) {
+		unsigned __int128 e = pack(exp);
+		unsigned __int128 old = __sync_val_compare_and_swap((volatile unsigned __int128*)ui, e, pack(des));
+		if (old == e) {
+			return true;
+		}
+		memcpy(&exp, &old, sizeof(old));
+		return false;
+	}
+};
+
+// Cache line padded wideAtomic
+template<typename T>
+class paddedWideAtomic {
+public:
+	wideAtomic<T> ui;
+private:
+	uint8_t pad[ 0 != sizeof(wideAtomic<T>)%CACHE_LINE_SIZE
+        ?  CACHE_LINE_SIZE - (sizeof(wideAtomic<T>)%CACHE_LINE_SIZE)
+        : CACHE_LINE_SIZE ];
+};
+#endif
+
+
+
 // Counted pointer, used to eliminate ABA problem
+// On 32-bit builds the pointer and sequence number get 32 bits each.
+// On 64-bit builds the pointer keeps the low 48 bits (all of x86-64 user
+// space) and the sequence number is cut to 16 bits so the pair still fits
+// in one CAS word.
+#if UINTPTR_MAX > 0xffffffffu
+#define CPTR_SN_BITS 16
+#else
+#define CPTR_SN_BITS 32
+#endif
+#define CPTR_SN_MASK ((((uint64_t)1) << CPTR_SN_BITS) - 1)
+
 template <class T>
 class cptr;
 
@@ -100,9 +185,9 @@ public:
 	void init(T* ptr, uint32_t sn){
 		uint64_t a;
 		a = 0;
-		a = (uint32_t)ptr;
-		a = a<<32;
-		a += sn;
+		a = (uintptr_t)ptr;
+		a = a<<CPTR_SN_BITS;
+		a += sn & CPTR_SN_MASK;
 		ui=a;
 	}
 	void init(uint64_t initer){
@@ -131,8 +216,8 @@ public:
 	}
 
 
-	T* ptr(){return (T*)((ui&0xffffffff00000000) >>32);}
-	uint32_t sn(){return (ui&0x00000000ffffffff);}
+	T* ptr(){return (T*)(uintptr_t)(ui>>CPTR_SN_BITS);}
+	uint32_t sn(){return (ui&CPTR_SN_MASK);}
 
 	cptr_local<T>(){
 		init(NULL,0);
@@ -162,9 +247,9 @@ public:
 	void init(T* ptr, uint32_t sn){
 		uint64_t a;
 		a = 0;
-		a = (uint32_t)ptr;
-		a = a<<32;
-		a += sn;
+		a = (uintptr_t)ptr;
+		a = a<<CPTR_SN_BITS;
+		a += sn & CPTR_SN_MASK;
 		ui.store(a,std::memory_order::memory_order_release);
 	}
 	void init(uint64_t initer){
@@ -178,8 +263,8 @@ public:
   // conversion to T (type-cast operator)
   operator T*() {return this->ptr();}
 
-	T* ptr(){return (T*)(((ui.load(std::memory_order::memory_order_consume))&0xffffffff00000000) >>32);}
-	uint32_t sn(){return ((ui.load(std::memory_order::memory_order_consume))&0x00000000ffffffff);}
+	T* ptr(){return (T*)(uintptr_t)((ui.load(std::memory_order::memory_order_consume))>>CPTR_SN_BITS);}
+	uint32_t sn(){return ((ui.load(std::memory_order::memory_order_consume))&CPTR_SN_MASK);}
 
 	uint64_t all(){
 		return ui;
@@ -0,0 +1,71 @@
+#include "EpochTracker.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+using namespace std;
+
+
+EpochTracker::EpochTracker(int task_num, RAllocator* mem, int emptyFreq, bool collect){
+	this->task_num = task_num;
+	this->freq = emptyFreq;
+	this->mem = mem;
+	epoch.ui.store(0);
+	reservations = new paddedAtomic<uint64_t>[task_num];
+	retired = new padded<list<pair<void*,uint64_t>>>[task_num];
+	cntrs = new padded<int>[task_num];
+	for (int i = 0; i<task_num; i++){
+		reservations[i].ui.store(QUIESCENT);
+		retired[i].ui = list<pair<void*,uint64_t>>();
+		cntrs[i]=0;
+	}
+	this->collect = collect;
+}
+
+EpochTracker::EpochTracker(int task_num, RAllocator* mem, int emptyFreq) :
+	EpochTracker(task_num, mem, emptyFreq, true){
+}
+
+EpochTracker::~EpochTracker(){
+	delete[] reservations;
+	delete[] retired;
+	delete[] cntrs;
+}
+
+void EpochTracker::enter(int tid){
+	if(reservations[tid].ui.load(memory_order_relaxed)!=QUIESCENT){return;}
+	// seq_cst store: the announcement must be visible before any shared pointer is read
+	reservations[tid].ui.store(epoch.ui.load(memory_order_acquire), memory_order_seq_cst);
+}
+
+void EpochTracker::exit(int tid){
+	reservations[tid].ui.store(QUIESCENT, memory_order_release);
+}
+
+void EpochTracker::retire(void* ptr, int tid){
+	if(ptr==NULL){return;}
+	retired[tid].ui.push_back(make_pair(ptr, epoch.ui.load(memory_order_acquire)));
+	if(collect && cntrs[tid]==freq){
+		cntrs[tid]=0;
+		epoch.ui.fetch_add(1, memory_order_acq_rel);
+		empty(tid);
+	}
+	cntrs[tid].ui++;
+}
+
+void EpochTracker::empty(int tid){
+	uint64_t oldest = QUIESCENT;
+	for (int i = 0; i<task_num; i++){
+		uint64_t e = reservations[i].ui.load(memory_order_seq_cst);
+		if(e<oldest){
+			oldest = e;
+		}
+	}
+
+	// the list is in retire order, so epochs only grow along it
+	list<pair<void*,uint64_t>>* myTrash = &(retired[tid].ui);
+	while(!myTrash->empty() && myTrash->front().second<oldest){
+		mem->freeBlock(myTrash->front().first,tid);
+		myTrash->pop_front();
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef EPOCH_TRACKER_HPP
+#define EPOCH_TRACKER_HPP
+
+#ifndef _REENTRANT
+#define _REENTRANT
+#endif
+
+#include <list>
+#include <atomic>
+#include <utility>
+#include <stdint.h>
+#include "ConcurrentPrimitives.hpp"
+#include "RAllocator.hpp"
+
+/*
+ * Epoch based reclamation with the same retire interface as HazardTracker.
+ * Instead of reserving every pointer it reads, a thread announces the
+ * global epoch when it starts an operation (enter) and withdraws it when
+ * it is done (exit).  A block retired in epoch e is freed once every
+ * thread is either outside an operation or has announced an epoch after e.
+ * Every emptyFreq retires the retiring thread advances the global epoch
+ * and frees what it can from its own list.
+ */
+class EpochTracker{
+private:
+	int task_num;
+	int freq;
+	bool collect;
+
+	RAllocator* mem;
+
+	paddedAtomic<uint64_t> epoch;
+	paddedAtomic<uint64_t>* reservations;
+	padded<int>* cntrs;
+	padded<std::list<std::pair<void*,uint64_t>>>* retired; // (block, epoch it was retired in)
+
+	static const uint64_t QUIESCENT = UINT64_MAX;
+
+public:
+	EpochTracker(int task_num, RAllocator* mem, int emptyFreq, bool collect);
+	EpochTracker(int task_num, RAllocator* mem, int emptyFreq);
+	// blocks still retired are left to mem
+	~EpochTracker();
+
+	// announce the current epoch, unless the thread is already inside an operation
+	void enter(int tid);
+	void exit(int tid);
+
+	void retire(void* ptr, int tid);
+	void empty(int tid);
+
+};
+
+
+#endif
@@ -51,6 +51,35 @@ int numCores(){
 	return sysconf( _SC_NPROCESSORS_ONLN );
 }
 
+// reads a single integer from a sysfs file, -1 if it cannot
+static int readSysInt(const std::string &path){
+	FILE *f = fopen(path.c_str(), "r");
+	if(f == NULL){
+		return -1;
+	}
+	int value;
+	if(fscanf(f, "%d", &value) != 1){
+		value = -1;
+	}
+	fclose(f);
+	return value;
+}
+
+int cpuPackage(int cpu){
+	return readSysInt("/sys/devices/system/cpu/cpu"+std::to_string(cpu)+"/topology/physical_package_id");
+}
+
+int cpuLastLevelCache(int cpu){
+	// the highest numbered cache index is the last level
+	for(int index = 7; index >= 0; index--){
+		std::string dir = "/sys/devices/system/cpu/cpu"+std::to_string(cpu)+"/cache/index"+std::to_string(index);
+		if(readSysInt(dir+"/level") > 1){
+			return readSysInt(dir+"/id");
+		}
+	}
+	return -1;
+}
+
 int archBits(){
 	if(sizeof(void*) == 8){
 		return 64;
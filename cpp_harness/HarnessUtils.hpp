@@ -23,4 +23,8 @@ bool isInteger(const std::string & s);
 std::string machineName();
 int archBits();
 int numCores();
+// socket (physical package) of a CPU, -1 if unknown
+int cpuPackage(int cpu);
+// id of the last level cache a CPU shares with its core complex, -1 if unknown
+int cpuLastLevelCache(int cpu);
 #endif
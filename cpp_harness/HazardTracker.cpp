@@ -43,6 +43,12 @@ HazardTracker::HazardTracker(int task_num, RAllocator* mem, int slotsPerThread,
 	this->collect = true;
 }
 
+HazardTracker::~HazardTracker(){
+	delete[] slots;
+	delete[] retired;
+	delete[] cntrs;
+}
+
 void HazardTracker::reserve(void* ptr, int slot, int tid){
 	slots[tid*slotsPerThread+slot] = ptr;
 }
@@ -87,3 +93,12 @@ void HazardTracker::empty(int tid){
 	return;
 }
 
+
+bool HazardTracker::isReserved(void* ptr){
+	for (int i = 0; i<task_num*slotsPerThread; i++){
+		if(ptr == slots[i].ui){
+			return true;
+		}
+	}
+	return false;
+}
@@ -26,7 +26,8 @@ private:
 	padded<std::list<void*>>* retired; // @todo use different structure to prevent malloc locking....
 
 public:
-//	~HazardTracker();
+	// blocks still retired are left to mem
+	~HazardTracker();
 	HazardTracker(int task_num, RAllocator* mem, int slotsPerThread, int emptyFreq, bool collect);
 	HazardTracker(int task_num, RAllocator* mem, int slotsPerThread, int emptyFreq);
 
@@ -36,6 +37,8 @@ public:
 
 	void retire(void* ptr, int tid);
 	void empty(int tid);
+	// true if some thread has ptr in one of its slots
+	bool isReserved(void* ptr);
 	
 };
 
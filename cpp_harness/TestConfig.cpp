@@ -19,7 +19,7 @@ Rideable* GlobalTestConfig::allocRideable(){
 
 void GlobalTestConfig::printargdef(){
 	int i;
-	fprintf(stderr, "usage: %s [-m <test_mode>] [-r <rideable_test_object>] [-a <affinity_file>] [-i <interval>] [-p <num_procs>][-t <num_threads>] [-o <output_csv_file>] [-w <warm_up_MBs>] [-d <env_variable>=<value>] [-z] [-v] [-h]\n", argv0);
+	fprintf(stderr, "usage: %s [-m <test_mode>] [-r <rideable_test_object_index_or_name>] [-a <affinity_file>] [-i <interval>] [-p <num_procs>][-t <num_threads>] [-o <output_csv_file>] [-w <warm_up_MBs>] [-d <env_variable>=<value>] [-z] [-v] [-h]\n", argv0);
 	for(i = 0; i< rideableFactories.size(); i++){
 		fprintf(stderr, "Rideable %d : %s\n",i,rideableNames[i].c_str());
 	}
@@ -30,6 +30,7 @@ void GlobalTestConfig::printargdef(){
 
 void GlobalTestConfig::parseCommandLine(int argc, char** argv){
 	int c;
+	int i;
 	argv0 = argv[0];
 
 	// if no args, print help
@@ -67,7 +68,19 @@ void GlobalTestConfig::parseCommandLine(int argc, char** argv){
 				}
 				break;
 			case 'r':
-				this->rideableType = atoi(optarg);
+				// accept either the rideable's index or its name
+				if(isInteger(std::string(optarg))){
+					this->rideableType = atoi(optarg);
+				}
+				else{
+					this->rideableType = rideableFactories.size();
+					for(i = 0; i< rideableNames.size(); i++){
+						if(rideableNames[i]==optarg){
+							this->rideableType = i;
+							break;
+						}
+					}
+				}
 				if(rideableType>=rideableFactories.size()){
 					fprintf(stderr, "Invalid rideable (-r) option.\n");
 					printargdef();
@@ -2,26 +2,80 @@
 #define ELIMTABLE_HPP
 
 #include <atomic>
+#include <thread>
 #include <malloc.h>
 #include <cstdlib>
 #include <cinttypes>
+#include <vector>
 #include "ConcurrentPrimitives.hpp"
-
+#include "HarnessUtils.hpp"
+
+/*
+ * Elimination table: one padded slot per thread, where a push or pop that
+ * backed off waits for a partner of the opposite kind.  tryEliminatePush
+ * and tryEliminatePop scan other threads' slots from a random start.  By
+ * default they scan scanCount slots; with an adaptive table each thread
+ * keeps its own scan window instead, halved after a scan that found every
+ * slot idle and doubled after one that saw other operations but did not
+ * eliminate, as in the adaptive elimination back-off stack.
+ *
+ * Given the CPU each thread runs on, the table also sorts every partner
+ * into a distance class: same core complex (last level cache), same
+ * socket, or remote.  With nearFirst a scan visits the classes in that
+ * order, from a random start within each, so eliminations stay close
+ * while near partners are offering.
+ *
+ * Batch pushes can hand several values over at once: handOffBatch
+ * publishes the first MaxBatch values in the pushing thread's batch offer,
+ * and pops that find the deque empty call claimBatch, which takes the next
+ * unclaimed entries of some open offer with one fetch_add.  Entries are
+ * claimed in order, so once the offer is withdrawn the pusher pushes the
+ * unclaimed rest as usual; each claimed value counts as pushed and popped
+ * at its claim.  Offers are only made after some pop found no offer to
+ * claim from.
+ */
 template <typename T>
 class ElimTable
 {
 public:
-  ElimTable(int threadCount);
+  enum Distance
+  {
+    DIST_NEAR = 0,
+    DIST_SOCKET,
+    DIST_REMOTE,
+    DISTANCE_COUNT
+  };
+
+  // what a scan did: slots read per distance class, and the class of the
+  // partner it eliminated with (-1 if it found none, or was found itself)
+  struct ScanInfo
+  {
+    int scanned[DISTANCE_COUNT];
+    int partner;
+  };
+
+  // cpus maps tid to CPU; without it every partner counts as remote
+  ElimTable(int threadCount, bool adaptive = false, const std::vector<int> &cpus = std::vector<int>(), bool nearFirst = false);
 
   ~ElimTable();
 
   void insertPush(const T &value, int tid);
   bool removePush(int tid);
-  bool tryEliminatePush(int scanCount, const T &value, int tid);
+  // outInfo, if given, receives what the scan did
+  bool tryEliminatePush(int scanCount, const T &value, int tid, ScanInfo *outInfo = NULL);
 
   void insertPop(int tid);
   bool removePop(T &out, int tid);
-  bool tryEliminatePop(int scanCount, T &out, int tid);
+  bool tryEliminatePop(int scanCount, T &out, int tid, ScanInfo *outInfo = NULL);
+
+  // offer values[0..count-1] to pops for up to spins spins (if a pop asked
+  // for one), and return how many of them, always the first ones, pops took
+  int handOffBatch(const T *values, int count, int spins, int tid);
+  // claim up to max values from an open batch offer into out and return how
+  // many were claimed, 0 if no offer had any left
+  int claimBatch(T *out, int max, int tid);
+
+  static const int MaxBatch = 16;
 
 private:
   enum Flag
@@ -42,15 +96,53 @@ private:
     Flag m_flag;
   };
 
+  struct BatchOffer
+  {
+    // index of the next entry to claim, BatchClosed while no offer is open
+    std::atomic<int> m_next;
+    std::atomic<int> m_count;
+    // entries claimed and copied out by pops
+    std::atomic<int> m_taken;
+    // entries claimed from the last offer, only read by the owner
+    int m_lastClaimed;
+    T m_values[MaxBatch];
+  };
+
+  static const int BatchClosed = 1 << 30;
+
+  int scanWindow(int scanCount, int tid);
+  int partnerAt(int start, int n, int tid);
+  bool endScan(bool eliminated, bool sawActive, const ScanInfo &info, ScanInfo *outInfo, int tid);
+
   padded<std::atomic<Slot>> *m_pTable;
 
   padded<int> *m_pRandNumbers;
 
+  // per-thread scan window of an adaptive table
+  padded<int> *m_pWindows;
+
+  padded<BatchOffer> *m_pBatches;
+
+  // open batch offers, and whether a pop found none since the last offer
+  paddedAtomic<int> m_openBatches;
+  paddedAtomic<bool> m_batchWanted;
+
+  // m_pDistance[tid * m_threadCount + i]: distance class of thread i from tid
+  unsigned char *m_pDistance;
+
+  // with nearFirst, the other threads by distance from tid at
+  // m_pOrder[tid * m_threadCount], DISTANCE_COUNT classes ending at
+  // m_pClassEnd[tid * DISTANCE_COUNT + c]
+  int *m_pOrder;
+  int *m_pClassEnd;
+
   const int m_threadCount;
+  const bool m_adaptive;
+  const bool m_nearFirst;
 };
 
 template <typename T>
-ElimTable<T>::ElimTable(int threadCount) : m_threadCount(threadCount)
+ElimTable<T>::ElimTable(int threadCount, bool adaptive, const std::vector<int> &cpus, bool nearFirst) : m_threadCount(threadCount), m_adaptive(adaptive), m_nearFirst(nearFirst)
 {
   m_pTable = (padded<std::atomic<Slot>> *)memalign(CACHE_LINE_SIZE, sizeof(padded<std::atomic<Slot>>) * threadCount);
   assert(m_pTable);
@@ -67,6 +159,64 @@ ElimTable<T>::ElimTable(int threadCount) : m_threadCount(threadCount)
   {
     m_pRandNumbers[i].ui = rand();
   }
+
+  m_pWindows = (padded<int> *)memalign(CACHE_LINE_SIZE, sizeof(padded<int>) * threadCount);
+  assert(m_pWindows);
+
+  for (int i = 0; i < threadCount; ++i)
+  {
+    m_pWindows[i].ui = threadCount;
+  }
+
+  m_pBatches = (padded<BatchOffer> *)memalign(CACHE_LINE_SIZE, sizeof(padded<BatchOffer>) * threadCount);
+  assert(m_pBatches);
+
+  for (int i = 0; i < threadCount; ++i)
+  {
+    m_pBatches[i].ui.m_next.store(BatchClosed);
+    m_pBatches[i].ui.m_count.store(0);
+    m_pBatches[i].ui.m_taken.store(0);
+    m_pBatches[i].ui.m_lastClaimed = 0;
+  }
+  m_openBatches.ui.store(0);
+  m_batchWanted.ui.store(false);
+
+  std::vector<int> package(threadCount, -1), cache(threadCount, -1);
+  for (int i = 0; i < threadCount && i < (int)cpus.size(); ++i)
+  {
+    package[i] = cpuPackage(cpus[i]);
+    cache[i] = cpuLastLevelCache(cpus[i]);
+  }
+
+  m_pDistance = new unsigned char[threadCount * threadCount];
+  m_pOrder = new int[threadCount * threadCount];
+  m_pClassEnd = new int[threadCount * DISTANCE_COUNT];
+
+  for (int t = 0; t < threadCount; ++t)
+  {
+    for (int i = 0; i < threadCount; ++i)
+    {
+      Distance d = DIST_REMOTE;
+      if (package[t] >= 0 && package[t] == package[i])
+      {
+        d = (cache[t] >= 0 && cache[t] == cache[i]) ? DIST_NEAR : DIST_SOCKET;
+      }
+      m_pDistance[t * threadCount + i] = d;
+    }
+
+    int n = 0;
+    for (int d = 0; d < DISTANCE_COUNT; ++d)
+    {
+      for (int i = 0; i < threadCount; ++i)
+      {
+        if (i != t && m_pDistance[t * threadCount + i] == d)
+        {
+          m_pOrder[t * threadCount + n++] = i;
+        }
+      }
+      m_pClassEnd[t * DISTANCE_COUNT + d] = n;
+    }
+  }
 }
 
 template <typename T>
@@ -74,6 +224,11 @@ ElimTable<T>::~ElimTable()
 {
   free(m_pTable);
   free(m_pRandNumbers);
+  free(m_pWindows);
+  free(m_pBatches);
+  delete[] m_pDistance;
+  delete[] m_pOrder;
+  delete[] m_pClassEnd;
 }
 
 template <typename T>
@@ -98,9 +253,10 @@ bool ElimTable<T>::removePush(int tid)
     return true;
   }
 
+  // a pop may have eliminated with us since the load
   slot = m_pTable[tid].ui.exchange(Slot(FLAG_INACTIVE), std::memory_order_acq_rel);
 
-  return (slot.m_flag == FLAG_INACTIVE);
+  return (slot.m_flag == FLAG_ELIMINATED);
 }
 
 template <typename T>
@@ -114,9 +270,10 @@ bool ElimTable<T>::removePop(T &out, int tid)
     return true;
   }
 
+  // a push may have eliminated with us since the load
   slot = m_pTable[tid].ui.exchange(Slot(FLAG_INACTIVE), std::memory_order_acq_rel);
 
-  if (slot.m_flag == FLAG_INACTIVE)
+  if (slot.m_flag == FLAG_ELIMINATED)
   {
     out = slot.m_value;
     return true;
@@ -126,30 +283,36 @@ bool ElimTable<T>::removePop(T &out, int tid)
 }
 
 template <typename T>
-bool ElimTable<T>::tryEliminatePop(int scanCount, T &out, int tid)
+bool ElimTable<T>::tryEliminatePop(int scanCount, T &out, int tid, ScanInfo *outInfo)
 {
   m_pRandNumbers[tid].ui = nextRand(m_pRandNumbers[tid].ui);
   int s = m_pRandNumbers[tid].ui;
 
-  scanCount = (m_threadCount < scanCount) ? m_threadCount : scanCount;
+  scanCount = scanWindow(scanCount, tid);
+  bool sawActive = false;
+  ScanInfo info = ScanInfo();
+  info.partner = -1;
 
   for (int n = 0; n < scanCount; ++n)
   {
-    int i = (s + n) % m_threadCount;
+    int i = partnerAt(s, n, tid);
 
     if (i == tid)
     {
       continue;
     }
 
+    Distance distance = (Distance)m_pDistance[tid * m_threadCount + i];
+    ++info.scanned[distance];
     for (;;)
     {
       Slot slot = m_pTable[i].ui.load(std::memory_order_acquire);
       if (slot.m_flag == FLAG_PUSH)
       {
+        sawActive = true;
         if (removePop(out, tid))
         {
-          return true;
+          return endScan(true, sawActive, info, outInfo, tid);
         }
 
         T value = slot.m_value;
@@ -157,66 +320,222 @@ bool ElimTable<T>::tryEliminatePop(int scanCount, T &out, int tid)
         if (m_pTable[i].ui.compare_exchange_strong(slot, Slot(FLAG_ELIMINATED), std::memory_order_acq_rel, std::memory_order_acquire))
         {
           out = value;
-          return true;
+          info.partner = distance;
+          return endScan(true, sawActive, info, outInfo, tid);
         }
 
         insertPop(tid);
       }
       else
       {
+        sawActive |= (slot.m_flag == FLAG_POP);
         break;
       }
     }
   }
 
-  return false;
+  return endScan(false, sawActive, info, outInfo, tid);
 }
 
 template <typename T>
-bool ElimTable<T>::tryEliminatePush(int scanCount, const T &value, int tid)
+bool ElimTable<T>::tryEliminatePush(int scanCount, const T &value, int tid, ScanInfo *outInfo)
 {
   m_pRandNumbers[tid].ui = nextRand(m_pRandNumbers[tid].ui);
   int s = m_pRandNumbers[tid].ui;
 
-  scanCount = (m_threadCount < scanCount) ? m_threadCount : scanCount;
+  scanCount = scanWindow(scanCount, tid);
+  bool sawActive = false;
+  ScanInfo info = ScanInfo();
+  info.partner = -1;
 
   for (int n = 0; n < scanCount; ++n)
   {
-    int i = (s + n) % m_threadCount;
+    int i = partnerAt(s, n, tid);
 
     if (i == tid)
     {
       continue;
     }
 
+    Distance distance = (Distance)m_pDistance[tid * m_threadCount + i];
+    ++info.scanned[distance];
     for (;;)
     {
-      assert((unsigned)&m_pTable[i] % CACHE_LINE_SIZE == 0);
+      assert((uintptr_t)&m_pTable[i] % CACHE_LINE_SIZE == 0);
 
       Slot slot = m_pTable[i].ui.load(std::memory_order_acquire);
 
       if (slot.m_flag == FLAG_POP)
       {
+        sawActive = true;
         if (removePush(tid))
         {
-          return true;
+          return endScan(true, sawActive, info, outInfo, tid);
         }
 
         if (m_pTable[i].ui.compare_exchange_strong(slot, Slot(value, FLAG_ELIMINATED), std::memory_order_acq_rel, std::memory_order_acquire))
         {
-          return true;
+          info.partner = distance;
+          return endScan(true, sawActive, info, outInfo, tid);
         }
 
         insertPush(value, tid);
       }
       else
       {
+        sawActive |= (slot.m_flag == FLAG_PUSH);
         break;
       }
     }
   }
 
-  return false;
+  return endScan(false, sawActive, info, outInfo, tid);
+}
+
+template <typename T>
+int ElimTable<T>::handOffBatch(const T *values, int count, int spins, int tid)
+{
+  if (!m_batchWanted.ui.load(std::memory_order_relaxed))
+  {
+    return 0;
+  }
+  m_batchWanted.ui.store(false, std::memory_order_relaxed);
+
+  BatchOffer &offer = m_pBatches[tid].ui;
+
+  // pops that claimed from the last offer may still be copying out
+  for (int n = 0; offer.m_taken.load(std::memory_order_acquire) != offer.m_lastClaimed; ++n)
+  {
+    if (n >= 64)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  count = (count < MaxBatch) ? count : MaxBatch;
+  for (int i = 0; i < count; ++i)
+  {
+    offer.m_values[i] = values[i];
+  }
+  offer.m_count.store(count, std::memory_order_relaxed);
+  offer.m_taken.store(0, std::memory_order_relaxed);
+  offer.m_next.store(0, std::memory_order_release);
+  m_openBatches.ui.fetch_add(1, std::memory_order_release);
+
+  for (int n = 0; n < spins && offer.m_next.load(std::memory_order_relaxed) < count; ++n)
+  {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  int next = offer.m_next.exchange(BatchClosed, std::memory_order_acq_rel);
+  m_openBatches.ui.fetch_sub(1, std::memory_order_relaxed);
+  offer.m_lastClaimed = (next < count) ? next : count;
+  return offer.m_lastClaimed;
+}
+
+template <typename T>
+int ElimTable<T>::claimBatch(T *out, int max, int tid)
+{
+  if (m_openBatches.ui.load(std::memory_order_acquire) == 0)
+  {
+    if (!m_batchWanted.ui.load(std::memory_order_relaxed))
+    {
+      m_batchWanted.ui.store(true, std::memory_order_relaxed);
+    }
+    return 0;
+  }
+
+  m_pRandNumbers[tid].ui = nextRand(m_pRandNumbers[tid].ui);
+  int s = m_pRandNumbers[tid].ui;
+  max = (max < MaxBatch) ? max : MaxBatch;
+
+  for (int n = 0; n < m_threadCount; ++n)
+  {
+    int i = partnerAt(s, n, tid);
+    if (i == tid)
+    {
+      continue;
+    }
+
+    BatchOffer &offer = m_pBatches[i].ui;
+    if (offer.m_next.load(std::memory_order_relaxed) >= offer.m_count.load(std::memory_order_relaxed))
+    {
+      continue;
+    }
+
+    // the acquire pairs with the release that opened the offer, so
+    // m_count and the values belong to the offer the index is from
+    int index = offer.m_next.fetch_add(max, std::memory_order_acq_rel);
+    int count = offer.m_count.load(std::memory_order_relaxed);
+    if (index >= count)
+    {
+      continue;
+    }
+
+    int claimed = (count - index < max) ? count - index : max;
+    for (int j = 0; j < claimed; ++j)
+    {
+      out[j] = offer.m_values[index + j];
+    }
+    offer.m_taken.fetch_add(claimed, std::memory_order_release);
+    return claimed;
+  }
+  return 0;
+}
+
+// slots to scan: scanCount, or the thread's window in an adaptive table
+template <typename T>
+int ElimTable<T>::scanWindow(int scanCount, int tid)
+{
+  if (m_adaptive)
+  {
+    return m_pWindows[tid].ui;
+  }
+  return (m_threadCount < scanCount) ? m_threadCount : scanCount;
+}
+
+// thread at position n of a scan from random start: the slots in index
+// order, or the other threads nearest first, each class rotated by start
+template <typename T>
+int ElimTable<T>::partnerAt(int start, int n, int tid)
+{
+  if (!m_nearFirst)
+  {
+    return (start + n) % m_threadCount;
+  }
+  if (n >= m_threadCount - 1)
+  {
+    return tid;
+  }
+  const int *classEnd = m_pClassEnd + tid * DISTANCE_COUNT;
+  int begin = 0;
+  int d = 0;
+  while (n >= classEnd[d])
+  {
+    begin = classEnd[d++];
+  }
+  int size = classEnd[d] - begin;
+  return m_pOrder[tid * m_threadCount + begin + (start + n - begin) % size];
+}
+
+// a miss on an idle table shrinks the window, a miss among other operations
+// (lost collisions or only operations of the same kind) widens it
+template <typename T>
+bool ElimTable<T>::endScan(bool eliminated, bool sawActive, const ScanInfo &info, ScanInfo *outInfo, int tid)
+{
+  if (outInfo)
+  {
+    *outInfo = info;
+  }
+  if (m_adaptive && !eliminated)
+  {
+    int window = m_pWindows[tid].ui;
+    window = sawActive ? window * 2 : window / 2;
+    m_pWindows[tid].ui = (window < 1) ? 1 : (window > m_threadCount) ? m_threadCount : window;
+  }
+  return eliminated;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#ifndef ELIMINATINGDEQUE_HPP
+#define ELIMINATINGDEQUE_HPP
+
+#include <cassert>
+#include <cinttypes>
+#include <malloc.h>
+
+#include "RDeque.hpp"
+#include "Rideable.hpp"
+#include "ElimTable.hpp"
+#include "ConcurrentPrimitives.hpp"
+
+/*
+ * Puts an elimination table in front of each end of any RDeque.  A push
+ * first tries the inner deque's try_*_push_uncontended; if the deque is
+ * busy (or cannot tell) it offers its value in its side's table and scans
+ * for a waiting pop on the same side.  A pop does the converse.  Only
+ * operations that find no partner go on to the inner deque's blocking
+ * call.  A push and a pop that meet at the same
+ * end may both take effect at the moment they meet, so the result is
+ * still a linearizable deque.
+ *
+ * Inner is the wrapped deque's type (RDeque to call it through the
+ * vtable).  The tables take -d elimrange, -d elimorder and -d elimbatch
+ * like OFDeque's; every try scans up to one slot per thread.  Batches go
+ * to the inner deque once any batch offer is withdrawn; peeks, sizes and
+ * waiting pops go straight to it.
+ */
+template<typename Inner> class EliminatingDeque : public RDeque {
+public:
+	/* --- Constructors & Destructor --- */
+	EliminatingDeque(Inner *deque, int threadCount, bool adaptive = false, const std::vector<int> &cpus = std::vector<int>(), bool nearFirst = false, bool batch = false);
+	~EliminatingDeque();
+	/* --- Instance Methods (Interface) --- */
+	void left_push(int32_t val, int tid) { doPush(m_pLeftElimTable, false, val, tid); }
+	void right_push(int32_t val, int tid) { doPush(m_pRightElimTable, true, val, tid); }
+	int32_t left_pop(int tid) { return doPop(m_pLeftElimTable, false, tid); }
+	int32_t right_pop(int tid) { return doPop(m_pRightElimTable, true, tid); }
+	void left_push_n(const int32_t *vals, int n, int tid);
+	void right_push_n(const int32_t *vals, int n, int tid);
+	int left_pop_n(int32_t *out, int n, int tid) { return m_pDeque->left_pop_n(out, n, tid); }
+	int right_pop_n(int32_t *out, int n, int tid) { return m_pDeque->right_pop_n(out, n, tid); }
+	int32_t peek_left(int tid) { return m_pDeque->peek_left(tid); }
+	int32_t peek_right(int tid) { return m_pDeque->peek_right(tid); }
+	long size_approx(int tid) { return m_pDeque->size_approx(tid); }
+	long min_capacity() { return m_pDeque->min_capacity(); }
+	int32_t left_pop_wait(int tid, long timeoutUs = -1) { return m_pDeque->left_pop_wait(tid, timeoutUs); }
+	int32_t right_pop_wait(int tid, long timeoutUs = -1) { return m_pDeque->right_pop_wait(tid, timeoutUs); }
+	void addThreadLogs(Recorder *r);
+	void reportThreadLogs(Recorder *r, int tid);
+private:
+	/* --- Inner Types --- */
+	struct ThreadLog {
+		int m_pushes;
+		int m_pops;
+	};
+
+	/* --- Instance Methods (Auxiliary) --- */
+	void doPush(ElimTable<int32_t> *table, bool right, int32_t val, int tid);
+	int32_t doPop(ElimTable<int32_t> *table, bool right, int tid);
+
+	/* --- Static Fields --- */
+	/* spins a batch offer stays open for pops to claim from */
+	static const int BatchWindow = 256;
+
+	/* --- Instance Fields --- */
+	Inner *m_pDeque;
+	ElimTable<int32_t> *m_pLeftElimTable;
+	ElimTable<int32_t> *m_pRightElimTable;
+	padded<ThreadLog> *m_pThreadLogs;
+	const int m_threadCount;
+	const bool m_batch;
+};
+
+/*
+ * Wraps the rideables another factory builds, which must be of type Inner.
+ */
+template<typename Inner> class EliminatingDequeFactory : public RContainerFactory {
+public:
+	EliminatingDequeFactory(RContainerFactory *inner) : m_pInner(inner) { }
+	~EliminatingDequeFactory() { delete m_pInner; }
+	RContainer *build(GlobalTestConfig *gtc) {
+		Inner *deque = dynamic_cast<Inner*>(m_pInner->build(gtc));
+		if (!deque) {
+			errexit("EliminatingDeque needs a deque of its Inner type.");
+		}
+		bool adaptive = gtc->environment.count("elimrange") && gtc->environment["elimrange"] == "adaptive";
+		bool nearFirst = gtc->environment.count("elimorder") && gtc->environment["elimorder"] == "near";
+		bool batch = gtc->environment.count("elimbatch") && gtc->environment["elimbatch"] == "1";
+		return new EliminatingDeque<Inner>(deque, gtc->task_num, adaptive, gtc->affinities, nearFirst, batch);
+	}
+private:
+	RContainerFactory *m_pInner;
+};
+
+/* --- Implementation --- */
+
+template<typename Inner>
+EliminatingDeque<Inner>::EliminatingDeque(Inner *deque, int threadCount, bool adaptive, const std::vector<int> &cpus, bool nearFirst, bool batch) :
+	m_pDeque(deque),
+	m_threadCount(threadCount),
+	m_batch(batch) {
+	void *elimTable;
+
+	elimTable = memalign(CACHE_LINE_SIZE, sizeof(ElimTable<int32_t>));
+	m_pLeftElimTable = new (elimTable) ElimTable<int32_t>(threadCount, adaptive, cpus, nearFirst);
+
+	elimTable = memalign(CACHE_LINE_SIZE, sizeof(ElimTable<int32_t>));
+	m_pRightElimTable = new (elimTable) ElimTable<int32_t>(threadCount, adaptive, cpus, nearFirst);
+
+	m_pThreadLogs = (padded<ThreadLog>*)memalign(CACHE_LINE_SIZE, sizeof(padded<ThreadLog>) * threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		m_pThreadLogs[i].ui.m_pushes = 0;
+		m_pThreadLogs[i].ui.m_pops = 0;
+	}
+}
+
+template<typename Inner>
+EliminatingDeque<Inner>::~EliminatingDeque() {
+	m_pLeftElimTable->~ElimTable<int32_t>();
+	m_pRightElimTable->~ElimTable<int32_t>();
+	free(m_pLeftElimTable);
+	free(m_pRightElimTable);
+	free(m_pThreadLogs);
+	delete m_pDeque;
+}
+
+/*
+ * Push @val straight into the inner deque if nobody else is in it.
+ * Otherwise offer @val, scan for a pop, and withdraw the offer unless a
+ * pop took it in the meantime; only then push into the inner deque.
+ */
+template<typename Inner>
+void EliminatingDeque<Inner>::doPush(ElimTable<int32_t> *table, bool right, int32_t val, int tid) {
+	if (right ? m_pDeque->try_right_push_uncontended(val, tid) : m_pDeque->try_left_push_uncontended(val, tid)) {
+		return;
+	}
+	table->insertPush(val, tid);
+	if (table->tryEliminatePush(m_threadCount, val, tid) || table->removePush(tid)) {
+		m_pThreadLogs[tid].ui.m_pushes++;
+		return;
+	}
+	if (right) {
+		m_pDeque->right_push(val, tid);
+	} else {
+		m_pDeque->left_push(val, tid);
+	}
+}
+
+template<typename Inner>
+int32_t EliminatingDeque<Inner>::doPop(ElimTable<int32_t> *table, bool right, int tid) {
+	int32_t val;
+	if (!(right ? m_pDeque->try_right_pop_uncontended(&val, tid) : m_pDeque->try_left_pop_uncontended(&val, tid))) {
+		table->insertPop(tid);
+		if (table->tryEliminatePop(m_threadCount, val, tid) || table->removePop(val, tid)) {
+			m_pThreadLogs[tid].ui.m_pops++;
+			return val;
+		}
+		val = right ? m_pDeque->right_pop(tid) : m_pDeque->left_pop(tid);
+	}
+	if (val == EMPTY && m_batch && table->claimBatch(&val, 1, tid) == 1) {
+		m_pThreadLogs[tid].ui.m_pops++;
+	}
+	return val;
+}
+
+/*
+ * Batches first offer their leading values to pops that found the deque
+ * empty (-d elimbatch=1), then push the rest into the inner deque.
+ */
+template<typename Inner>
+void EliminatingDeque<Inner>::left_push_n(const int32_t *vals, int n, int tid) {
+	int handed = m_batch ? m_pLeftElimTable->handOffBatch(vals, n, BatchWindow, tid) : 0;
+	m_pThreadLogs[tid].ui.m_pushes += handed;
+	m_pDeque->left_push_n(vals + handed, n - handed, tid);
+}
+
+template<typename Inner>
+void EliminatingDeque<Inner>::right_push_n(const int32_t *vals, int n, int tid) {
+	int handed = m_batch ? m_pRightElimTable->handOffBatch(vals, n, BatchWindow, tid) : 0;
+	m_pThreadLogs[tid].ui.m_pushes += handed;
+	m_pDeque->right_push_n(vals + handed, n - handed, tid);
+}
+
+template<typename Inner>
+void EliminatingDeque<Inner>::addThreadLogs(Recorder *r) {
+	m_pDeque->addThreadLogs(r);
+	r->addThreadField("eliminatedPushes_total", &Recorder::sumInts);
+	r->addThreadField("eliminatedPops_total", &Recorder::sumInts);
+}
+
+template<typename Inner>
+void EliminatingDeque<Inner>::reportThreadLogs(Recorder *r, int tid) {
+	m_pDeque->reportThreadLogs(r, tid);
+	r->reportThreadInfo("eliminatedPushes_total", m_pThreadLogs[tid].ui.m_pushes, tid);
+	r->reportThreadInfo("eliminatedPops_total", m_pThreadLogs[tid].ui.m_pops, tid);
+	m_pThreadLogs[tid].ui.m_pushes = 0;
+	m_pThreadLogs[tid].ui.m_pops = 0;
+}
+
+#endif
@@ -12,7 +12,7 @@
 #include "ConcurrentPrimitives.hpp"
 
 template <typename T>
-class FCDeque : public RDeque
+class FCDeque : public RDequeOf<T>
 {
 public:
   FCDeque(int threadCount, T empty);
@@ -25,6 +25,15 @@ public:
   T right_pop(int tid);
   T left_pop(int tid);
 
+  T peek_right(int tid);
+  T peek_left(int tid);
+  long size_approx(int tid);
+
+  bool try_right_push_uncontended(T value, int tid);
+  bool try_left_push_uncontended(T value, int tid);
+  bool try_right_pop_uncontended(T *value, int tid);
+  bool try_left_pop_uncontended(T *value, int tid);
+
 private:
   enum REQUEST_STATUS
   {
@@ -53,22 +62,26 @@ private:
       return status.load(o);
     }
 
-    volatile T value;
+    // published by the release store to status, so it need not be volatile
+    T value;
     std::atomic<REQUEST_STATUS> status;
-    char pad0[LEVEL1_DCACHE_LINESIZE - sizeof(std::atomic<REQUEST_STATUS>) - sizeof(T)];
+    char pad0[0 != (sizeof(std::atomic<REQUEST_STATUS>) + sizeof(T)) % LEVEL1_DCACHE_LINESIZE
+              ? LEVEL1_DCACHE_LINESIZE - (sizeof(std::atomic<REQUEST_STATUS>) + sizeof(T)) % LEVEL1_DCACHE_LINESIZE
+              : LEVEL1_DCACHE_LINESIZE];
   };
 
   /* --- Instance Methods (Auxiliary) --- */
 
   bool isLocked();
   bool tryLock(int tid);
+  void lock(int tid);
   void unlock(int tid);
   void doCombining(int tid);
 
   /* --- Instance Fields -- */
 
   std::deque<T> m_deque;
-  char pad0[LEVEL1_DCACHE_LINESIZE - sizeof(std::deque<T>)];
+  char pad0[LEVEL1_DCACHE_LINESIZE - sizeof(std::deque<T>) % LEVEL1_DCACHE_LINESIZE];
 
   volatile int m_nLock;
   char pad1[LEVEL1_DCACHE_LINESIZE - sizeof(int)];
@@ -223,6 +236,35 @@ T FCDeque<T>::left_pop(int tid)
   return myRequest->value;
 }
 
+// Peeks and sizes read the deque under the combiner lock without combining,
+// so waiting operations are served by the next combiner.
+template <typename T>
+T FCDeque<T>::peek_right(int tid)
+{
+  lock(tid);
+  T value = m_deque.empty() ? m_empty : m_deque.back();
+  unlock(tid);
+  return value;
+}
+
+template <typename T>
+T FCDeque<T>::peek_left(int tid)
+{
+  lock(tid);
+  T value = m_deque.empty() ? m_empty : m_deque.front();
+  unlock(tid);
+  return value;
+}
+
+template <typename T>
+long FCDeque<T>::size_approx(int tid)
+{
+  lock(tid);
+  long size = m_deque.size();
+  unlock(tid);
+  return size;
+}
+
 template <typename T>
 void FCDeque<T>::doCombining(int tid)
 {
@@ -289,6 +331,67 @@ void FCDeque<T>::doCombining(int tid)
   }
 }
 
+// The uncontended variants run their own operation only if the combiner
+// lock is free, without publishing a request or combining, so waiting
+// operations are served by the next combiner as with peeks.
+template <typename T>
+bool FCDeque<T>::try_right_push_uncontended(T value, int tid)
+{
+  if (isLocked() || !tryLock(tid))
+  {
+    return false;
+  }
+  m_deque.push_back(value);
+  unlock(tid);
+  return true;
+}
+
+template <typename T>
+bool FCDeque<T>::try_left_push_uncontended(T value, int tid)
+{
+  if (isLocked() || !tryLock(tid))
+  {
+    return false;
+  }
+  m_deque.push_front(value);
+  unlock(tid);
+  return true;
+}
+
+template <typename T>
+bool FCDeque<T>::try_right_pop_uncontended(T *value, int tid)
+{
+  if (isLocked() || !tryLock(tid))
+  {
+    return false;
+  }
+  *value = m_empty;
+  if (!m_deque.empty())
+  {
+    *value = m_deque.back();
+    m_deque.pop_back();
+  }
+  unlock(tid);
+  return true;
+}
+
+template <typename T>
+bool FCDeque<T>::try_left_pop_uncontended(T *value, int tid)
+{
+  if (isLocked() || !tryLock(tid))
+  {
+    return false;
+  }
+  *value = m_empty;
+  if (!m_deque.empty())
+  {
+    *value = m_deque.front();
+    m_deque.pop_front();
+  }
+  unlock(tid);
+  return true;
+}
+
 template <typename T>
 bool FCDeque<T>::isLocked()
 {
@@ -301,6 +404,14 @@ bool FCDeque<T>::tryLock(int tid)
   return __sync_lock_test_and_set(&m_nLock, 1) == 0;
 }
 
+template <typename T>
+void FCDeque<T>::lock(int tid)
+{
+  while (isLocked() || !tryLock(tid))
+  {
+  }
+}
+
 template <typename T>
 void FCDeque<T>::unlock(int tid)
 {
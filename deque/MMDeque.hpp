@@ -16,7 +16,7 @@
  * Implementation of Maged Michael's lock-free deque
  */
 
-template<typename T> class MMDeque : public RDeque {
+template<typename T> class MMDeque : public RDequeOf<T> {
 
 private:
 
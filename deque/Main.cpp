@@ -8,9 +8,13 @@
 #include "Harness.hpp" // main harness header
 #include "DefaultHarnessTests.hpp"
 #include "SGLDeque.hpp"
-#include "MMDeque.hpp"
 #include "OFDeque.hpp"
+#if UINTPTR_MAX <= 0xffffffffu
+#include "MMDeque.hpp"
+#endif
 #include "FCDeque.hpp"
+#include "PayloadDeque.hpp"
+#include "EliminatingDeque.hpp"
 #include "WSDeque.hpp"
 #include "scal-master/src/datastructures/ts_deque.h"
 
@@ -32,23 +36,65 @@ int main(int argc, char *argv[])
   gtc = new GlobalTestConfig();
 
   gtc->addRideableOption(new SGLDequeFactory(), "SGLDeque");
+#if UINTPTR_MAX <= 0xffffffffu
+  // MMDeque packs pointers into 32-bit words, so it is only available in
+  // the 32-bit build
   gtc->addRideableOption(new MMDequeFactory(), "MMDeque");
+#endif
   gtc->addRideableOption(new FCDequeFactory(), "FCDeque");
 
-  gtc->addRideableOption(new OFDequeFactory<512, true>(), "OFDeque_512");
-  gtc->addRideableOption(new OFDequeFactory<1024, true>(), "OFDeque_1024");
-  gtc->addRideableOption(new OFDequeFactory<4096, true>(), "OFDeque_4096");
-  gtc->addRideableOption(new OFDequeFactory<8192, true>(), "OFDeque_8192");
-
-  gtc->addRideableOption(new OFDequeFactory<512, false>(), "OFDeque_512_NoElim");
-  gtc->addRideableOption(new OFDequeFactory<1024, false>(), "OFDeque_1024_NoElim");
-  gtc->addRideableOption(new OFDequeFactory<4096, false>(), "OFDeque_4096_NoElim");
-  gtc->addRideableOption(new OFDequeFactory<8192, false>(), "OFDeque_8192_NoElim");
+  // OFDeque and OFDeque_NoElim take their buffer size from -d bufsize=N
+  // (default 512) or size buffers adaptively with -d bufsize=adaptive; the
+  // sized names only change the default.  All OFDequeFactory rideables take
+  // their contention manager from -d cm=none|exp|polka|spinyield
+  gtc->addRideableOption(new OFDequeFactory<true>(512), "OFDeque");
+  gtc->addRideableOption(new OFDequeFactory<false>(512), "OFDeque_NoElim");
+  // same, built with OFDequeCountStats: per thread counters appear as
+  // <counter>_total columns
+  gtc->addRideableOption(new OFDequeFactory<true, OFDequeCountStats>(512), "OFDeque_Stats");
+  gtc->addRideableOption(new OFDequeFactory<false, OFDequeCountStats>(512), "OFDeque_NoElim_Stats");
+  // epoch based reclamation (OFDequeEpochs) instead of hazard pointers
+  gtc->addRideableOption(new OFDequeFactory<true, OFDequeNoStats, OFDequeEpochs>(512), "OFDeque_Epoch");
+  gtc->addRideableOption(new OFDequeFactory<false, OFDequeNoStats, OFDequeEpochs>(512), "OFDeque_NoElim_Epoch");
+  gtc->addRideableOption(new OFDequeFactory<true, OFDequeCountStats, OFDequeEpochs>(512), "OFDeque_Epoch_Stats");
+  gtc->addRideableOption(new OFDequeFactory<false, OFDequeCountStats, OFDequeEpochs>(512), "OFDeque_NoElim_Epoch_Stats");
+
+  gtc->addRideableOption(new OFDequeFactory<true>(512), "OFDeque_512");
+  gtc->addRideableOption(new OFDequeFactory<true>(1024), "OFDeque_1024");
+  gtc->addRideableOption(new OFDequeFactory<true>(4096), "OFDeque_4096");
+  gtc->addRideableOption(new OFDequeFactory<true>(8192), "OFDeque_8192");
+
+  gtc->addRideableOption(new OFDequeFactory<false>(512), "OFDeque_512_NoElim");
+  gtc->addRideableOption(new OFDequeFactory<false>(1024), "OFDeque_1024_NoElim");
+  gtc->addRideableOption(new OFDequeFactory<false>(4096), "OFDeque_4096_NoElim");
+  gtc->addRideableOption(new OFDequeFactory<false>(8192), "OFDeque_8192_NoElim");
+
+  // 8, 32 and 128 byte payloads (see PayloadDeque.hpp)
+  gtc->addRideableOption(new OFDequePayloadFactory<8, true>(512), "OFDeque_512_P8");
+  gtc->addRideableOption(new OFDequePayloadFactory<32, true>(512), "OFDeque_512_P32");
+  gtc->addRideableOption(new OFDequePayloadFactory<128, true>(512), "OFDeque_512_P128");
+  gtc->addRideableOption(new FCDequePayloadFactory<8>(), "FCDeque_P8");
+  gtc->addRideableOption(new FCDequePayloadFactory<32>(), "FCDeque_P32");
+  gtc->addRideableOption(new FCDequePayloadFactory<128>(), "FCDeque_P128");
+#if UINTPTR_MAX <= 0xffffffffu
+  gtc->addRideableOption(new MMDequePayloadFactory<8>(), "MMDeque_P8");
+  gtc->addRideableOption(new MMDequePayloadFactory<32>(), "MMDeque_P32");
+  gtc->addRideableOption(new MMDequePayloadFactory<128>(), "MMDeque_P128");
+#endif
 
   gtc->addRideableOption(new WSDequeFactory(), "WSDeque");
   gtc->addRideableOption(new TSDequeFactory(), "TSDeque-HWClock");
   gtc->addRideableOption(new TSDequeFactory(TSDequeFactory::AtomicCounterTS), "TSDeque-FAI");
 
+  // elimination tables in front of deques that have none (see
+  // EliminatingDeque.hpp), with -d elimrange and -d elimorder as for OFDeque
+  gtc->addRideableOption(new EliminatingDequeFactory<SGLDeque<int32_t> >(new SGLDequeFactory()), "SGLDeque+Elim");
+#if UINTPTR_MAX <= 0xffffffffu
+  gtc->addRideableOption(new EliminatingDequeFactory<MMDeque<int32_t> >(new MMDequeFactory()), "MMDeque+Elim");
+#endif
+  gtc->addRideableOption(new EliminatingDequeFactory<FCDeque<int32_t> >(new FCDequeFactory()), "FCDeque+Elim");
+  gtc->addRideableOption(new EliminatingDequeFactory<RDeque>(new OFDequeFactory<false>(512)), "OFDeque_NoElim+Elim");
+
   gtc->addTestOption(new FAITest(), "FAI Test");
   gtc->addTestOption(new PotatoTest(0), "PotatoTest(0 ms delay)");
   gtc->addTestOption(new PotatoTest(1), "PotatoTest(1 ms delay)");
@@ -57,6 +103,14 @@ int main(int argc, char *argv[])
   gtc->addTestOption(new QueueVerificationTest(), "QueueVerificationTest");
   gtc->addTestOption(new StackVerificationTest(), "StackVerificationTest");
   gtc->addTestOption(new DequeLatencyTest(), "DequeLatencyTest");
+  gtc->addTestOption(new EdgeSearchTest(), "EdgeSearchTest");
+  gtc->addTestOption(new OpLatencyTest(), "OpLatencyTest");
+  gtc->addTestOption(new ImbalanceTest(), "ImbalanceTest");
+  gtc->addTestOption(new OscillationTest(), "OscillationTest");
+  gtc->addTestOption(new PeekTest(), "PeekTest");
+  gtc->addTestOption(new WakeTest(), "WakeTest");
+  gtc->addTestOption(new FanOutTest(), "FanOutTest");
+  gtc->addTestOption(new BoundedPushTest(), "BoundedPushTest");
 
   try
   {
@@ -6,13 +6,64 @@
 #include <atomic>
 #include <cassert>
 #include <cinttypes> 
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 #include "RDeque.hpp"
 #include "ElimTable.hpp"
+#include "ValueArena.hpp"
 #include "BlockPool.hpp"
 #include "HazardTracker.hpp"
+#include "EpochTracker.hpp"
+#include "HarnessUtils.hpp"
 #include "ConcurrentPrimitives.hpp"
 
+/*
+ * Slot width.  A slot is two words: a value or buffer link and a count/type
+ * word.  On 32-bit builds that is one 64-bit word updated with cmpxchg8b.
+ * On 64-bit builds the slot is 16 bytes (full 64-bit value or link, 62-bit
+ * count) and is updated with cmpxchg16b, so build with -mcx16.
+ *
+ * Defining OFDEQUE_INDEXED_LINKS keeps 64-bit builds at 8 byte slots: buffer
+ * links and global hints name buffers by their 32-bit index in a contiguous
+ * BlockPool arena, values are limited to 4 bytes and every slot and hint CAS
+ * stays a single-word cmpxchg.
+ */
+#if UINTPTR_MAX > 0xffffffffu && !defined(OFDEQUE_INDEXED_LINKS)
+#define OFDEQUE_WIDE_SLOTS 1
+#else
+#define OFDEQUE_WIDE_SLOTS 0
+#endif
+
+/*
+ * Paired slot CAS.  With 8 byte slots on a machine with cmpxchg16b (the
+ * LINKS=index build), an interior push whose near and far slots fill one
+ * aligned 16 byte word can update both with a single CAS (-d paircas=1).
+ */
+#if !OFDEQUE_WIDE_SLOTS && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define OFDEQUE_PAIRED_CAS 1
+#else
+#define OFDEQUE_PAIRED_CAS 0
+#endif
+
+/*
+ * Edge search.  Defining OFDEQUE_AVX2_EDGE_SEARCH (make SIMD=avx2) lets
+ * findEdge skip runs of equally typed slots 32 bytes at a time, i.e. 4
+ * slots of 8 bytes or 2 of 16 bytes per compare and movemask.  Without it
+ * the same runs are skipped one loadType at a time.
+ */
+#ifdef OFDEQUE_AVX2_EDGE_SEARCH
+#ifndef __AVX2__
+#error "OFDEQUE_AVX2_EDGE_SEARCH needs -mavx2"
+#endif
+#include <immintrin.h>
+#endif
+
 namespace OFDequeTypes {
 	enum Type {
 		TYPE_LEFT = 0,
@@ -25,50 +76,793 @@ namespace OFDequeTypes {
 		SIDE_LEFT = 0,
 		SIDE_RIGHT = 1
 	};
+
+	/* result of try_left_push/try_right_push */
+	enum PushResult {
+		PUSHED = 0,
+		FULL = 1
+	};
+};
+
+template<OFDequeTypes::Side S, typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> struct OFDequeUtils;
+class EdgeSearchTest;
+
+/*
+ * Buffer capacity in slots.  With m_min == m_max every buffer has that size.
+ * Otherwise each side picks the size of the buffers it appends from its
+ * recent append/retire rate, doubling or halving between m_min and m_max
+ * (see OFDeque::noteAppend), and buffers of different sizes share a chain.
+ */
+struct OFDequeBufferSizes {
+	/* --- Static Methods (Interface) --- */
+	static OFDequeBufferSizes Fixed(int size) {
+		OFDequeBufferSizes sizes = { size, size, size };
+		return sizes;
+	}
+	static OFDequeBufferSizes Adaptive(int min, int max) {
+		OFDequeBufferSizes sizes = { min, min, max };
+		/* start from the smallest power-of-two multiple of min that reaches 512 */
+		while (sizes.m_initial < 512 && sizes.m_initial * 2 <= max) {
+			sizes.m_initial *= 2;
+		}
+		return sizes;
+	}
+	/* -d bufsize=N picks a fixed size, -d bufsize=adaptive an adaptive one
+	 * between -d bufmin (default 64) and -d bufmax (default 8192) */
+	static OFDequeBufferSizes FromEnvironment(GlobalTestConfig *gtc, int defaultSize) {
+		std::map<std::string, std::string>::iterator it = gtc->environment.find("bufsize");
+		OFDequeBufferSizes sizes = Fixed(defaultSize);
+		if (it != gtc->environment.end()) {
+			if (it->second == "adaptive") {
+				int min = gtc->environment.count("bufmin") ? atoi(gtc->environment["bufmin"].c_str()) : 64;
+				int max = gtc->environment.count("bufmax") ? atoi(gtc->environment["bufmax"].c_str()) : 8192;
+				sizes = Adaptive(min, max);
+			} else {
+				sizes = Fixed(atoi(it->second.c_str()));
+			}
+		}
+		if (sizes.m_min < MinSize || sizes.m_max < sizes.m_min) {
+			errexit("OFDeque buffer sizes must be at least 8 slots, with bufmin <= bufmax.");
+		}
+		return sizes;
+	}
+
+	/* --- Instance Methods (Interface) --- */
+	bool isAdaptive() const { return m_min != m_max; }
+
+	/* --- Instance Fields --- */
+	int m_initial;
+	int m_min;
+	int m_max;
+
+	/* --- Static Fields --- */
+	static const int MinSize = 8;
+};
+
+/*
+ * Per side reserve of ready-to-link buffers.  Appending needs a buffer whose
+ * slots all carry the far type; taking one from the reserve keeps that
+ * initialization (m_size slot stores) off the append.  Popping threads top
+ * the reserve up after they pop, or a helper thread does when m_helper is
+ * set.  A depth of 0 disables the reserve.
+ */
+struct OFDequeReserve {
+	/* --- Static Methods (Interface) --- */
+	static OFDequeReserve None() {
+		OFDequeReserve reserve = { 0, false };
+		return reserve;
+	}
+	static OFDequeReserve Depth(int depth, bool helper = false) {
+		OFDequeReserve reserve = { depth, helper };
+		return reserve;
+	}
+	/* -d reserve=N keeps N buffers per side, -d reserve_helper=1 refills them
+	 * from a helper thread instead of from pops */
+	static OFDequeReserve FromEnvironment(GlobalTestConfig *gtc) {
+		OFDequeReserve reserve = None();
+		if (gtc->environment.count("reserve")) {
+			reserve.m_depth = atoi(gtc->environment["reserve"].c_str());
+		}
+		if (gtc->environment.count("reserve_helper")) {
+			reserve.m_helper = gtc->environment["reserve_helper"] == "1";
+		}
+		if (reserve.m_depth < 0 || reserve.m_depth > MaxDepth) {
+			errexit("OFDeque reserve depth must be between 0 and 64.");
+		}
+		if (reserve.m_helper && reserve.m_depth == 0) {
+			errexit("OFDeque reserve_helper needs a reserve depth (-d reserve=N).");
+		}
+		return reserve;
+	}
+
+	/* --- Instance Fields --- */
+	int m_depth;
+	bool m_helper;
+
+	/* --- Static Fields --- */
+	static const int MaxDepth = 64;
+};
+
+/*
+ * Parameters of the contention managers (see OFDequeExpBackoff and the
+ * policies after it), in spin iterations: -d cm_min=N and -d cm_max=N bound
+ * a single backoff delay, -d cm_spins=N is how many consecutive failures
+ * spin-then-yield spins on before it yields, -d cm_announce=K after how many
+ * consecutive failures announce-and-defer announces an operation.
+ */
+struct OFDequeContention {
+	/* --- Static Methods (Interface) --- */
+	static OFDequeContention Defaults() {
+		OFDequeContention contention;
+		contention.m_min = 16;
+		contention.m_max = 4096;
+		contention.m_spins = 4;
+		contention.m_announce = 4;
+		return contention;
+	}
+	static OFDequeContention FromEnvironment(GlobalTestConfig *gtc) {
+		OFDequeContention contention = Defaults();
+		if (gtc->environment.count("cm_min")) {
+			contention.m_min = atoi(gtc->environment["cm_min"].c_str());
+		}
+		if (gtc->environment.count("cm_max")) {
+			contention.m_max = atoi(gtc->environment["cm_max"].c_str());
+		}
+		if (gtc->environment.count("cm_spins")) {
+			contention.m_spins = atoi(gtc->environment["cm_spins"].c_str());
+		}
+		if (gtc->environment.count("cm_announce")) {
+			contention.m_announce = atoi(gtc->environment["cm_announce"].c_str());
+		}
+		if (contention.m_min < 1 || contention.m_max < contention.m_min || contention.m_spins < 0 || contention.m_announce < 1) {
+			errexit("OFDeque needs 1 <= cm_min <= cm_max, cm_spins >= 0 and cm_announce >= 1.");
+		}
+		return contention;
+	}
+
+	/* --- Instance Fields --- */
+	int m_min;
+	int m_max;
+	int m_spins;
+	int m_announce;
+};
+
+/*
+ * Thresholds of the flat-combining fallback (-d hybrid=1, see
+ * OFDeque::combine).  A side starts combining when its operations fail
+ * -d hybrid_on=N or more attempts (backoffs and oracle restarts) per 100
+ * operations, and stops when its combining passes serve fewer than
+ * -d hybrid_off=N requests each on average.
+ */
+struct OFDequeHybrid {
+	/* --- Static Methods (Interface) --- */
+	static OFDequeHybrid Off() {
+		OFDequeHybrid hybrid = { false, 50, 2 };
+		return hybrid;
+	}
+	static OFDequeHybrid FromEnvironment(GlobalTestConfig *gtc) {
+		OFDequeHybrid hybrid = Off();
+		hybrid.m_enabled = gtc->environment.count("hybrid") && gtc->environment["hybrid"] == "1";
+		if (gtc->environment.count("hybrid_on")) {
+			hybrid.m_on = atoi(gtc->environment["hybrid_on"].c_str());
+		}
+		if (gtc->environment.count("hybrid_off")) {
+			hybrid.m_off = atoi(gtc->environment["hybrid_off"].c_str());
+		}
+		if (hybrid.m_on < 1 || hybrid.m_off < 1) {
+			errexit("OFDeque needs hybrid_on >= 1 and hybrid_off >= 1.");
+		}
+		return hybrid;
+	}
+
+	/* --- Instance Fields --- */
+	bool m_enabled;
+	/* failed attempts per 100 operations */
+	int m_on;
+	/* requests per combining pass */
+	int m_off;
+};
+
+/*
+ * Run-time options of an OFDeque, read from -d key=value pairs by
+ * FromEnvironment.
+ */
+struct OFDequeOptions {
+	/* --- Static Methods (Interface) --- */
+	static OFDequeOptions Defaults(int bufferSize = 512) {
+		OFDequeOptions options;
+		options.m_sizes = OFDequeBufferSizes::Fixed(bufferSize);
+		options.m_reserve = OFDequeReserve::None();
+		options.m_edgeCache = false;
+		options.m_edgeMap = false;
+		options.m_maxBuffers = 0;
+		options.m_linger = 0;
+		options.m_hintPeriod = 1;
+		options.m_pairCas = false;
+		options.m_adaptiveElim = false;
+		options.m_nearFirstElim = false;
+		options.m_batchElim = false;
+		options.m_hybrid = OFDequeHybrid::Off();
+		options.m_contention = OFDequeContention::Defaults();
+		return options;
+	}
+	static OFDequeOptions FromEnvironment(GlobalTestConfig *gtc, int defaultBufferSize) {
+		OFDequeOptions options;
+		options.m_sizes = OFDequeBufferSizes::FromEnvironment(gtc, defaultBufferSize);
+		options.m_reserve = OFDequeReserve::FromEnvironment(gtc);
+		options.m_edgeCache = gtc->environment.count("edgecache") && gtc->environment["edgecache"] == "1";
+		options.m_edgeMap = gtc->environment.count("edgemap") && gtc->environment["edgemap"] == "1";
+		options.m_maxBuffers = 0;
+		if (gtc->environment.count("maxbuffers")) {
+			options.m_maxBuffers = atoi(gtc->environment["maxbuffers"].c_str());
+		} else if (gtc->environment.count("capacity")) {
+			/* enough of the smallest buffers for the capacity, plus the half-used first one */
+			int perBuffer = options.m_sizes.m_min - 2;
+			options.m_maxBuffers = (atoi(gtc->environment["capacity"].c_str()) + perBuffer - 1) / perBuffer + 1;
+		}
+		if (options.m_maxBuffers != 0 && options.m_maxBuffers < MinBuffers) {
+			errexit("OFDeque maxbuffers must be 0 (unbounded) or at least 3.");
+		}
+		options.m_linger = gtc->environment.count("linger") ? atoi(gtc->environment["linger"].c_str()) : 0;
+		if (options.m_linger < 0 || options.m_linger > MaxLinger) {
+			errexit("OFDeque linger must be between 0 and 8.");
+		}
+		options.m_hintPeriod = gtc->environment.count("hintperiod") ? atoi(gtc->environment["hintperiod"].c_str()) : 1;
+		if (options.m_hintPeriod < 1 || (options.m_hintPeriod & (options.m_hintPeriod - 1)) != 0) {
+			errexit("OFDeque hintperiod must be a power of two.");
+		}
+		options.m_pairCas = gtc->environment.count("paircas") && gtc->environment["paircas"] == "1";
+		if (options.m_pairCas && !OFDEQUE_PAIRED_CAS) {
+			errexit("OFDeque paircas needs 8 byte slots and cmpxchg16b (make ARCH=64 LINKS=index).");
+		}
+		options.m_adaptiveElim = false;
+		if (gtc->environment.count("elimrange")) {
+			if (gtc->environment["elimrange"] == "adaptive") {
+				options.m_adaptiveElim = true;
+			} else if (gtc->environment["elimrange"] != "full") {
+				errexit("OFDeque elimrange must be full or adaptive.");
+			}
+		}
+		options.m_cpus = gtc->affinities;
+		options.m_nearFirstElim = false;
+		if (gtc->environment.count("elimorder")) {
+			if (gtc->environment["elimorder"] == "near") {
+				options.m_nearFirstElim = true;
+			} else if (gtc->environment["elimorder"] != "random") {
+				errexit("OFDeque elimorder must be random or near.");
+			}
+		}
+		options.m_batchElim = gtc->environment.count("elimbatch") && gtc->environment["elimbatch"] == "1";
+		options.m_hybrid = OFDequeHybrid::FromEnvironment(gtc);
+		options.m_contention = OFDequeContention::FromEnvironment(gtc);
+		return options;
+	}
+
+	/* --- Instance Fields --- */
+	OFDequeBufferSizes m_sizes;
+	OFDequeReserve m_reserve;
+	/* -d edgecache=1: per-thread edge cache, see OFDeque::oracle */
+	bool m_edgeCache;
+	/* -d edgemap=1: per-buffer map of cache lines holding an edge, see OFDeque::findEdge */
+	bool m_edgeMap;
+	/* -d maxbuffers=N (or -d capacity=N elements): bound the chain to N buffers (0: unbounded), see OFDeque::claimBuffer */
+	int m_maxBuffers;
+	/* -d linger=K: keep the last K buffers unlinked on each side for the next appends (0: retire at once), see OFDeque::linger */
+	int m_linger;
+	/* -d hintperiod=P: write the local hint after about one in P interior operations (1: every one), see OFDeque::moveLocalHint */
+	int m_hintPeriod;
+	/* -d paircas=1: push into an aligned pair of slots with one 16 byte CAS, see OFDeque::casPush */
+	bool m_pairCas;
+	/* -d elimrange=adaptive: per-thread elimination scan windows (full: scan every thread), see ElimTable */
+	bool m_adaptiveElim;
+	/* -d elimorder=near: scan elimination partners nearest first (random: from a random slot), see ElimTable */
+	bool m_nearFirstElim;
+	/* -d elimbatch=1: batch pushes offer values to pops that find the deque empty, see ElimTable::handOffBatch */
+	bool m_batchElim;
+	/* -d hybrid=1: route a contended side's operations through a combiner, see OFDeque::combine */
+	OFDequeHybrid m_hybrid;
+	/* CPU of each thread (GlobalTestConfig::affinities), empty if unknown */
+	std::vector<int> m_cpus;
+	OFDequeContention m_contention;
+
+	/* --- Static Fields --- */
+	/* pops leave an emptied end buffer linked until they next cross it, so
+	 * an empty deque can hold one on each side of the edge buffer */
+	static const int MinBuffers = 3;
+	static const int MaxLinger = 8;
+};
+
+/*
+ * Statistics.  The Stats template argument of OFDeque decides what a thread
+ * log holds: OFDequeNoStats keeps nothing and every count compiles away,
+ * OFDequeCountStats keeps one int per counter and thread.  The counters are
+ * reported through the Recorder as <name>_total thread fields.
+ */
+namespace OFDequeStats {
+	enum Counter {
+		STD_PUSHES,
+		ELIM_PUSHES,
+		STD_POPS,
+		ELIM_POPS,
+		EMPTY_POPS,
+		ORACLE_INVOKES,
+		ORACLE_LOOPS,
+		APPENDS,
+		REMOVES,
+		SEALS,
+		STRADDLES,
+		BACKOFFS,
+		CAS_FAILS_SAFE,
+		CAS_FAILS_VALUE,
+		CAS_FAILS_TYPE,
+		CAS_FAILS_LINK,
+		INLINE_INITS,
+		RESERVE_TAKES,
+		EDGE_CACHE_HITS,
+		EDGE_MAP_JUMPS,
+		FULLS,
+		RETIRES,
+		RELINKS,
+		HINT_WRITES,
+		SLOT_CASES,
+		PAIR_CASES,
+		PEEKS,
+		PARKS,
+		WAKES,
+		ELIM_TRIES,
+		ELIM_LINES,
+		/* per ElimTable distance class: near, socket, remote */
+		ELIM_LINES_NEAR,
+		ELIM_LINES_SOCKET,
+		ELIM_LINES_REMOTE,
+		ELIM_HITS_NEAR,
+		ELIM_HITS_SOCKET,
+		ELIM_HITS_REMOTE,
+		ELIM_NS_NEAR,
+		ELIM_NS_SOCKET,
+		ELIM_NS_REMOTE,
+		BATCH_HANDOFFS,
+		BATCH_CLAIMS,
+		COMBINE_STARTS,
+		COMBINE_STOPS,
+		COMBINE_PASSES,
+		COMBINED_OPS,
+		COUNTER_COUNT
+	};
+
+	inline const char *GetName(Counter counter) {
+		static const char *const names[COUNTER_COUNT] = {
+			"stdPushes", "elimPushes", "stdPops", "elimPops", "emptyPops",
+			"oracleInvokes", "oracleLoops",
+			"appends", "removes", "seals", "straddles", "backoffs",
+			"casFailsSafe", "casFailsValue", "casFailsType", "casFailsLink",
+			"inlineInits", "reserveTakes", "edgeCacheHits", "edgeMapJumps",
+			"fulls", "retires", "relinks",
+			"hintWrites", "slotCases", "pairCases", "peeks", "parks", "wakes",
+			"elimTries", "elimLines",
+			"elimLinesNear", "elimLinesSocket", "elimLinesRemote",
+			"elimHitsNear", "elimHitsSocket", "elimHitsRemote",
+			"elimNsNear", "elimNsSocket", "elimNsRemote",
+			"batchHandoffs", "batchClaims",
+			"combineStarts", "combineStops", "combinePasses", "combinedOps"
+		};
+		return names[counter];
+	}
+};
+
+struct OFDequeNoStats {
+	struct ThreadLog { };
+
+	static const bool Enabled = false;
+	static inline void Add(ThreadLog &log, OFDequeStats::Counter counter, int n) { }
+	static inline int Get(const ThreadLog &log, OFDequeStats::Counter counter) { return 0; }
+};
+
+struct OFDequeCountStats {
+	struct ThreadLog {
+		int m_counts[OFDequeStats::COUNTER_COUNT];
+	};
+
+	static const bool Enabled = true;
+	static inline void Add(ThreadLog &log, OFDequeStats::Counter counter, int n) { log.m_counts[counter] += n; }
+	static inline int Get(const ThreadLog &log, OFDequeStats::Counter counter) { return log.m_counts[counter]; }
+};
+
+/*
+ * Reclamation.  The Reclaimer template argument of OFDeque decides how a
+ * thread keeps the buffers it reads from being freed under it, and when
+ * retired buffers go back to their BufferPool:
+ *  - OFDequeHazards reserves every buffer in one of two HazardTracker slots
+ *    before reading it, and the search then re-reads the global hint to
+ *    check the buffer was not retired in between (ReservesBuffers);
+ *  - OFDequeEpochs announces an epoch once when the oracle is first called
+ *    in an operation and withdraws it at clearAll, so the buffers read in
+ *    between need neither reserving nor validating (EpochTracker).
+ * isReserved tells whether an unlinked buffer may still be read by some
+ * thread; only a buffer it clears can be linked again (see OFDeque::linger).
+ */
+class OFDequeHazards {
+public:
+	static const bool ReservesBuffers = true;
+
+	OFDequeHazards(int threadCount, RAllocator *allocator) : m_tracker(threadCount, allocator, 2, 2) { }
+
+	inline void enter(int tid) { }
+	inline void reserve(void *buffer, int slot, int tid) { m_tracker.reserve(buffer, slot, tid); }
+	inline void clearAll(int tid) { m_tracker.clearAll(tid); }
+	inline void retire(void *buffer, int tid) { m_tracker.retire(buffer, tid); }
+	inline bool isReserved(void *buffer) { return m_tracker.isReserved(buffer); }
+
+private:
+	HazardTracker m_tracker;
+};
+
+class OFDequeEpochs {
+public:
+	static const bool ReservesBuffers = false;
+
+	OFDequeEpochs(int threadCount, RAllocator *allocator) : m_tracker(threadCount, allocator, 2) { }
+
+	inline void enter(int tid) { m_tracker.enter(tid); }
+	inline void reserve(void *buffer, int slot, int tid) { }
+	inline void clearAll(int tid) { m_tracker.exit(tid); }
+	inline void retire(void *buffer, int tid) { m_tracker.retire(buffer, tid); }
+	/* a thread's epoch does not say which buffers it reads, so any of them may
+	 * be in use; OFDequeFactory rejects -d linger with this reclaimer */
+	inline bool isReserved(void *buffer) { return true; }
+
+private:
+	EpochTracker m_tracker;
+};
+
+/*
+ * Contention management.  The ContentionManager template argument of
+ * OFDeque decides what a push or pop does after a failed attempt, once
+ * elimination (if any) has not paired it up.  begin and end bracket an
+ * operation, backoff follows every failed attempt.  OFDequeFactory picks
+ * the manager with -d cm=none|exp|polka|spinyield.  Managers other than
+ * OFDequeNoBackoff report cmBackoffs_total, cmSpins_total and
+ * cmYields_total thread fields.
+ */
+class OFDequeNoBackoff {
+public:
+	static const bool Enabled = false;
+
+	OFDequeNoBackoff(int threadCount, const OFDequeContention &params) { }
+
+	inline void begin(int tid) { }
+	inline void backoff(int tid) { }
+	inline void end(int tid) { }
+	void addThreadLogs(Recorder *r) { }
+	void reportThreadLogs(Recorder *r, int tid) { }
+};
+
+/* state and counters shared by the managers that delay */
+class OFDequeContentionBase {
+public:
+	static const bool Enabled = true;
+
+	OFDequeContentionBase(int threadCount, const OFDequeContention &params) : m_params(params) {
+		m_pThreads = new padded<ThreadState>[threadCount];
+		for (int i = 0; i < threadCount; ++i) {
+			ThreadState &state = m_pThreads[i].ui;
+			state.m_random = 0x9e3779b9u * (i + 1);
+			state.m_window = params.m_min;
+			state.m_failures = 0;
+			state.m_backoffs = 0;
+			state.m_spins = 0;
+			state.m_yields = 0;
+		}
+	}
+	~OFDequeContentionBase() { delete[] m_pThreads; }
+
+	void addThreadLogs(Recorder *r) {
+		r->addThreadField("cmBackoffs_total", &Recorder::sumInts);
+		r->addThreadField("cmSpins_total", &Recorder::sumInts);
+		r->addThreadField("cmYields_total", &Recorder::sumInts);
+	}
+	void reportThreadLogs(Recorder *r, int tid) {
+		ThreadState &state = m_pThreads[tid].ui;
+		r->reportThreadInfo("cmBackoffs_total", (int)state.m_backoffs, tid);
+		r->reportThreadInfo("cmSpins_total", (int)(state.m_spins >> 10), tid);
+		r->reportThreadInfo("cmYields_total", (int)state.m_yields, tid);
+	}
+
+protected:
+	struct ThreadState {
+		uint32_t m_random;
+		int m_window;
+		int m_failures;
+		/* counters; m_spins is reported in units of 1024 */
+		long m_backoffs;
+		long m_spins;
+		long m_yields;
+	};
+
+	/* spin for a random number of iterations in [0, @window) */
+	void delay(ThreadState &state, int window) {
+		state.m_random ^= state.m_random << 13;
+		state.m_random ^= state.m_random >> 17;
+		state.m_random ^= state.m_random << 5;
+		int spins = state.m_random % window;
+		for (int i = 0; i < spins; ++i) {
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+#if defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#endif
+		}
+		state.m_spins += spins;
+	}
+
+	void yield(ThreadState &state) {
+		std::this_thread::yield();
+		++state.m_yields;
+	}
+
+	const OFDequeContention m_params;
+	padded<ThreadState> *m_pThreads;
+};
+
+/* randomized exponential backoff: the delay window doubles up to cm_max with every failure */
+class OFDequeExpBackoff : public OFDequeContentionBase {
+public:
+	OFDequeExpBackoff(int threadCount, const OFDequeContention &params) : OFDequeContentionBase(threadCount, params) { }
+
+	inline void begin(int tid) { }
+	void backoff(int tid) {
+		ThreadState &state = m_pThreads[tid].ui;
+		++state.m_backoffs;
+		delay(state, state.m_window);
+		state.m_window = state.m_window * 2 > m_params.m_max ? m_params.m_max : state.m_window * 2;
+	}
+	inline void end(int tid) {
+		m_pThreads[tid].ui.m_window = m_params.m_min;
+	}
+};
+
+/*
+ * Polka (Scherer and Scott): a thread's karma is the number of attempts
+ * its current operation has made.  After a failure the thread picks a
+ * random other thread as the likely enemy and, if that one has more karma,
+ * backs off with exponentially growing random delays once per karma point
+ * of difference, or until the enemy's karma changes.  The thread with the
+ * most karma retries at once.
+ */
+class OFDequePolka : public OFDequeContentionBase {
+public:
+	OFDequePolka(int threadCount, const OFDequeContention &params) : OFDequeContentionBase(threadCount, params), m_threadCount(threadCount) {
+		m_pKarma = new paddedAtomic<int>[threadCount];
+		for (int i = 0; i < threadCount; ++i) {
+			m_pKarma[i].ui.store(0, std::memory_order_relaxed);
+		}
+	}
+	~OFDequePolka() { delete[] m_pKarma; }
+
+	inline void begin(int tid) { }
+	void backoff(int tid) {
+		ThreadState &state = m_pThreads[tid].ui;
+		int karma = m_pKarma[tid].ui.load(std::memory_order_relaxed) + 1;
+		m_pKarma[tid].ui.store(karma, std::memory_order_relaxed);
+		if (m_threadCount < 2) {
+			return;
+		}
+
+		int enemy = (tid + 1 + state.m_random % (m_threadCount - 1)) % m_threadCount;
+		int enemyKarma = m_pKarma[enemy].ui.load(std::memory_order_relaxed);
+		if (enemyKarma <= karma) {
+			state.m_random = state.m_random * 1103515245u + 12345u;
+			return;
+		}
+
+		++state.m_backoffs;
+		int window = m_params.m_min;
+		for (int i = karma; i < enemyKarma && m_pKarma[enemy].ui.load(std::memory_order_relaxed) == enemyKarma; ++i) {
+			delay(state, window);
+			window = window * 2 > m_params.m_max ? m_params.m_max : window * 2;
+		}
+	}
+	inline void end(int tid) {
+		m_pKarma[tid].ui.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	paddedAtomic<int> *m_pKarma;
+	const int m_threadCount;
+};
+
+/* spin cm_min iterations per consecutive failure for the first cm_spins failures, then yield */
+class OFDequeSpinYield : public OFDequeContentionBase {
+public:
+	OFDequeSpinYield(int threadCount, const OFDequeContention &params) : OFDequeContentionBase(threadCount, params) { }
+
+	inline void begin(int tid) { }
+	void backoff(int tid) {
+		ThreadState &state = m_pThreads[tid].ui;
+		++state.m_backoffs;
+		if (++state.m_failures <= m_params.m_spins) {
+			int window = state.m_failures * m_params.m_min;
+			delay(state, window > m_params.m_max ? m_params.m_max : window);
+		} else {
+			yield(state);
+		}
+	}
+	inline void end(int tid) {
+		m_pThreads[tid].ui.m_failures = 0;
+	}
 };
 
-template<OFDequeTypes::Side S, typename T, int BufferSize, bool Elimination> struct OFDequeUtils;
+/*
+ * Announce-and-defer.  After cm_announce consecutive failures an operation
+ * announces itself (one per deque at a time) and retries at once.  Any
+ * other operation that fails while one is announced waits for it to end,
+ * but only while the announcer keeps making attempts: once its attempt
+ * count has stood still for cm_min spins (it is probably descheduled) or
+ * the wait reaches cm_max spins, the waiter retries.  Nobody completes the
+ * announced operation for it; it only gets a near solo run.  Like the other
+ * managers this changes when operations retry, not what they do, so
+ * OFDeque stays obstruction-free and no operation gets a progress bound.
+ */
+class OFDequeAnnounce : public OFDequeContentionBase {
+public:
+	OFDequeAnnounce(int threadCount, const OFDequeContention &params) : OFDequeContentionBase(threadCount, params) {
+		m_announcement.m_owner.store(0, std::memory_order_relaxed);
+		m_announcement.m_attempts.store(0, std::memory_order_relaxed);
+		m_pAnnounces = new padded<long>[threadCount];
+		for (int i = 0; i < threadCount; ++i) {
+			m_pAnnounces[i].ui = 0;
+		}
+	}
+	~OFDequeAnnounce() { delete[] m_pAnnounces; }
+
+	inline void begin(int tid) { }
+	void backoff(int tid) {
+		ThreadState &state = m_pThreads[tid].ui;
+		Announcement &announcement = m_announcement;
+		int owner = announcement.m_owner.load(std::memory_order_acquire);
+		if (owner == tid + 1) {
+			/* only the announcer writes its attempt count */
+			announcement.m_attempts.store(announcement.m_attempts.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+		++state.m_failures;
+		if (owner == 0) {
+			int none = 0;
+			if (state.m_failures >= m_params.m_announce && announcement.m_owner.compare_exchange_strong(none, tid + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				++m_pAnnounces[tid].ui;
+			}
+			return;
+		}
+
+		++state.m_backoffs;
+		int attempts = announcement.m_attempts.load(std::memory_order_relaxed);
+		for (int i = 0, still = 0; i < m_params.m_max && still < m_params.m_min && announcement.m_owner.load(std::memory_order_acquire) == owner; ++i) {
+#if defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#endif
+			++state.m_spins;
+			int now = announcement.m_attempts.load(std::memory_order_relaxed);
+			still = (now == attempts) ? still + 1 : 0;
+			attempts = now;
+		}
+	}
+	inline void end(int tid) {
+		m_pThreads[tid].ui.m_failures = 0;
+		if (m_announcement.m_owner.load(std::memory_order_relaxed) == tid + 1) {
+			m_announcement.m_owner.store(0, std::memory_order_release);
+		}
+	}
+	void addThreadLogs(Recorder *r) {
+		OFDequeContentionBase::addThreadLogs(r);
+		r->addThreadField("cmAnnounces_total", &Recorder::sumInts);
+	}
+	void reportThreadLogs(Recorder *r, int tid) {
+		OFDequeContentionBase::reportThreadLogs(r, tid);
+		r->reportThreadInfo("cmAnnounces_total", (int)m_pAnnounces[tid].ui, tid);
+	}
+
+private:
+	struct Announcement {
+		/* tid + 1 of the announced operation's thread, 0 when none is announced */
+		std::atomic<int> m_owner;
+		/* attempts the announced operation has made, for waiters to see it is running */
+		std::atomic<int> m_attempts;
+	} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	Announcement m_announcement;
+	padded<long> *m_pAnnounces;
+};
 
-template<typename T, int BufferSize, bool Elimination=true> class OFDeque : public RDeque {
+template<typename T, bool Elimination=true, typename Stats=OFDequeNoStats, typename Reclaimer=OFDequeHazards, typename ContentionManager=OFDequeNoBackoff> class OFDeque : public RDeque {
 public:
-	static_assert(sizeof(T) <= 4, "template argument T is larger than 4 bytes");
 	/* --- Constructors & Destructor --- */
-	OFDeque(T empty, int threadCount, bool glibc);
+	OFDeque(T empty, int threadCount, bool glibc, OFDequeOptions options = OFDequeOptions::Defaults());
 	~OFDeque();
 	/* --- Instance Methods (Interface) --- */
 	void left_push(T value, int tid);
 	void right_push(T value, int tid);
 	T left_pop(int tid);
 	T right_pop(int tid);
+	// end value without removing it, the empty value if the deque was found empty
+	T peek_left(int tid);
+	T peek_right(int tid);
+	// values in the deque as of the threads' push and pop counts, see size_approx
+	long size_approx(int tid);
+	// values that fit before a push waits for room, see claimBuffer
+	long min_capacity();
+	// pop that parks on a futex while the deque is empty, see doPopWait
+	T left_pop_wait(int tid, long timeoutUs = -1);
+	T right_pop_wait(int tid, long timeoutUs = -1);
+	// push unless that needs a buffer beyond the -d maxbuffers limit, in which case return FULL
+	OFDequeTypes::PushResult try_left_push(T value, int tid);
+	OFDequeTypes::PushResult try_right_push(T value, int tid);
+	void left_push_n(const T *values, int count, int tid);
+	void right_push_n(const T *values, int count, int tid);
+	int left_pop_n(T *outValues, int count, int tid);
+	int right_pop_n(T *outValues, int count, int tid);
+	void addThreadLogs(Recorder *r);
+	void reportThreadLogs(Recorder *r, int tid);
 private:
 	/* --- Inner Types --- */
 	struct Buffer;
+#ifdef OFDEQUE_INDEXED_LINKS
+	typedef uint32_t BufferRef;
+	typedef uint32_t SlotWord;
+#else
+	typedef Buffer *BufferRef;
+	typedef uintptr_t SlotWord;
+#endif
+	static_assert(sizeof(T) <= sizeof(SlotWord), "template argument T is larger than a slot word");
+#if OFDEQUE_WIDE_SLOTS
+	template<typename U> using Atomic = wideAtomic<U>;
+	template<typename U> using PaddedAtomic = paddedWideAtomic<U>;
+#else
+	template<typename U> using Atomic = std::atomic<U>;
+	template<typename U> using PaddedAtomic = paddedAtomic<U>;
+#endif
+
 	struct Slot {
 		/* --- Instance Methods (Interface) --- */
-		inline bool operator==(const Slot &n) { return *((uint64_t*)this) == *((uint64_t*)&n); }
+		inline bool operator==(const Slot &n) {
+			return ((SlotWord*)this)[0] == ((SlotWord*)&n)[0] && ((SlotWord*)this)[1] == ((SlotWord*)&n)[1];
+		}
 
 		/* --- Instance Fields --- */
 		union {
 			T m_value;
-			Buffer *m_pLink;
+			BufferRef m_link;
 		};
 
 		struct {
-			uint32_t m_count : 30;
-			uint32_t m_type : 2;
+			SlotWord m_count : sizeof(SlotWord) * 8 - 2;
+			SlotWord m_type : 2;
 		};
-	};
+	} __attribute__ ((aligned(2 * sizeof(SlotWord))));
 	struct Buffer {
 		/* --- Instance Methods (Interface) --- */
 		void fill(int split);
 		int isSealed();
+		void resetEdgeMaps();
+
+		/*
+		 * Map of side @side with one bit per cache line of slots, set for the
+		 * lines that may hold that side's edge.  Only allocated (m_mapWords
+		 * != 0) when the deque runs with -d edgemap=1.
+		 */
+		std::atomic<uint64_t> *edgeMap(OFDequeTypes::Side side) {
+			return (std::atomic<uint64_t>*)(m_pSlots + GetSlotCapacity(m_size)) + (side == OFDequeTypes::SIDE_LEFT ? 0 : m_mapWords);
+		}
 
 		OFDequeTypes::Type loadType(int index, std::memory_order order = std::memory_order_relaxed) {
 			return (OFDequeTypes::Type)loadSlot(index, order).m_type;
 		}
 
 		Slot loadSlot(int index, std::memory_order order = std::memory_order_relaxed) {
-			return m_pSlots[index].load(order);
+			return slot(index).load(order);
+		}
+
+		/* slot at logical @index, wherever the slot layout puts it (see GetSlotOffset) */
+		Atomic<Slot> &slot(int index) {
+			return m_pSlots[GetSlotOffset(index)];
 		}
 
 		bool casSafe(int index, Slot exp) { 
@@ -76,14 +870,14 @@ private:
 			s.m_type = exp.m_type;
 			s.m_value = exp.m_value;
 			s.m_count = exp.m_count + 1;
-			return m_pSlots[index].compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
+			return slot(index).compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
 		}
 
 		bool casType(int index, Slot exp, OFDequeTypes::Type type) {
 			Slot s;
 			s.m_type = type;
 			s.m_count = exp.m_count + 1;
-			return m_pSlots[index].compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
+			return slot(index).compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
 		}
 
 		bool casValue(int index, Slot exp, const T &value) {
@@ -91,31 +885,281 @@ private:
 			s.m_type = OFDequeTypes::TYPE_VALUE;
 			s.m_value = value;
 			s.m_count = exp.m_count + 1;
-			return m_pSlots[index].compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
+			return slot(index).compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
+		}
+
+#if OFDEQUE_PAIRED_CAS
+		/* true when slots @a and @b are neighbours that fill one aligned 16 byte word */
+		bool isPair(int a, int b) {
+			uintptr_t low = (uintptr_t)&slot(a < b ? a : b);
+			uintptr_t high = (uintptr_t)&slot(a < b ? b : a);
+			return high == low + sizeof(Slot) && (low & (2 * sizeof(Slot) - 1)) == 0;
+		}
+
+		/* casSafe(@nearIndex) and casValue(@farIndex) as one cmpxchg16b, for slots that isPair;
+		 * on failure @nearChanged tells whether the near slot was the one that moved */
+		bool casSafeValue(int nearIndex, Slot nearExp, int farIndex, Slot farExp, const T &value, bool *nearChanged) {
+			Slot nearNew;
+			nearNew.m_type = nearExp.m_type;
+			nearNew.m_value = nearExp.m_value;
+			nearNew.m_count = nearExp.m_count + 1;
+			Slot farNew;
+			farNew.m_type = OFDequeTypes::TYPE_VALUE;
+			farNew.m_value = value;
+			farNew.m_count = farExp.m_count + 1;
+
+			bool nearLow = nearIndex < farIndex;
+			Slot exp[2] = { nearLow ? nearExp : farExp, nearLow ? farExp : nearExp };
+			Slot des[2] = { nearLow ? nearNew : farNew, nearLow ? farNew : nearNew };
+			unsigned __int128 e, d;
+			memcpy(&e, exp, sizeof(e));
+			memcpy(&d, des, sizeof(d));
+			unsigned __int128 seen = __sync_val_compare_and_swap((volatile unsigned __int128*)&slot(nearLow ? nearIndex : farIndex), e, d);
+			if (seen == e) {
+				return true;
+			}
+			/* the lower addressed slot is the low half of the word */
+			int nearShift = nearLow ? 0 : 8 * sizeof(Slot);
+			*nearChanged = (uint64_t)(seen >> nearShift) != (uint64_t)(e >> nearShift);
+			return false;
 		}
+#endif
 
-		bool casLink(int index, Slot exp, Buffer *link) {
+		bool casLink(int index, Slot exp, BufferRef link) {
 			Slot s;
 			s.m_type = OFDequeTypes::TYPE_VALUE;
-			s.m_pLink = link;
+			s.m_link = link;
 			s.m_count = exp.m_count + 1;
-			return m_pSlots[index].compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
+			return slot(index).compare_exchange_strong(exp, s, std::memory_order_acq_rel, std::memory_order_acquire);
 		}
 
 		/* --- Instance Fields --- */
 		paddedAtomic<int> m_leftLocalHint __attribute__ ((aligned(CACHE_LINE_SIZE)));
 		paddedAtomic<int> m_rightLocalHint __attribute__ ((aligned(CACHE_LINE_SIZE)));
-		std::atomic<Slot> m_pSlots[BufferSize];
+		/* set when the buffer is allocated, constant while it is in the chain */
+		int m_size;
+		int m_sizeClass;
+		/* words per edge map, 0 without edge maps */
+		int m_mapWords;
+		/* m_size slots (GetSlotCapacity(m_size) with padding), followed by the left and right edge maps, allocated with the buffer by its BufferPool */
+		Atomic<Slot> m_pSlots[0];
+	};
+
+	static const int SlotsPerLine = CACHE_LINE_SIZE / sizeof(Slot) > 0 ? CACHE_LINE_SIZE / sizeof(Slot) : 1;
+
+	static inline int GetEdgeMapWords(int size) {
+		return ((size + SlotsPerLine - 1) / SlotsPerLine + 63) / 64;
+	}
+
+	/*
+	 * Slot layout.  By default logical index i is slot i, so the two slots
+	 * of an interior push share a line, and on a nearly empty deque so do
+	 * both edges.  Built with OFDEQUE_STRIPED_SLOTS (make LAYOUT=striped),
+	 * every tile of SlotTile slots is stored transposed as SlotsPerLine
+	 * lines of SlotsPerLine: logical neighbours sit one line apart, and a
+	 * line holds every SlotsPerLine-th slot of its tile.  Buffers are padded
+	 * to whole tiles.
+	 */
+#ifdef OFDEQUE_STRIPED_SLOTS
+	static_assert((SlotsPerLine & (SlotsPerLine - 1)) == 0, "striped slots need a power of two slots per line");
+	static const int SlotTile = SlotsPerLine * SlotsPerLine;
+#else
+	static const int SlotTile = 1;
+#endif
+
+	static inline int GetSlotOffset(int index) {
+#ifdef OFDEQUE_STRIPED_SLOTS
+		return (index & ~(SlotTile - 1)) | ((index & (SlotsPerLine - 1)) * SlotsPerLine) | ((index / SlotsPerLine) & (SlotsPerLine - 1));
+#else
+		return index;
+#endif
+	}
+
+	static inline int GetSlotCapacity(int size) {
+		return (size + SlotTile - 1) / SlotTile * SlotTile;
+	}
+
+	/*
+	 * One BlockPool per buffer size.  Buffers remember the pool they came
+	 * from, so the HazardTracker can hand any of them back through freeBlock.
+	 * Size class k holds buffers of m_min << k slots (just m_min when sizes
+	 * are fixed).
+	 */
+	class BufferPool : public RAllocator {
+	public:
+		BufferPool(int threadCount, bool glibc, const OFDequeBufferSizes &sizes, bool edgeMap) : m_classCount(0), m_edgeMap(edgeMap) {
+			m_pRetired = new padded<RetiredBytes>[threadCount];
+			for (int i = 0; i < threadCount; ++i) {
+				m_pRetired[i].ui.m_current = 0;
+				m_pRetired[i].ui.m_peak = 0;
+			}
+			for (int size = sizes.m_min; size <= sizes.m_max && m_classCount < MaxClasses; size *= 2) {
+				unsigned long extra = GetSlotCapacity(size) * sizeof(Atomic<Slot>);
+				if (edgeMap) {
+					extra += 2 * GetEdgeMapWords(size) * sizeof(std::atomic<uint64_t>);
+				}
+#ifdef OFDEQUE_INDEXED_LINKS
+				unsigned long blocks = ArenaBytes / (sizeof(Buffer) + extra);
+				blocks = blocks < (1ul << ClassShift) ? blocks : (1ul << ClassShift);
+				m_pPools[m_classCount] = new BlockPool<Buffer>(threadCount, glibc, blocks, extra);
+#else
+				m_pPools[m_classCount] = new BlockPool<Buffer>(threadCount, glibc, 0, extra);
+#endif
+				m_bytes[m_classCount] = sizeof(Buffer) + extra;
+				m_sizes[m_classCount++] = size;
+				if (!sizes.isAdaptive()) {
+					break;
+				}
+			}
+		}
+
+		Buffer *alloc(int sizeClass, int tid) {
+			Buffer *buffer = m_pPools[sizeClass]->alloc(tid);
+			buffer->m_size = m_sizes[sizeClass];
+			buffer->m_sizeClass = sizeClass;
+			buffer->m_mapWords = m_edgeMap ? GetEdgeMapWords(buffer->m_size) : 0;
+			return buffer;
+		}
+
+		int getClassCount() { return m_classCount; }
+
+		int getSizeClass(int size) {
+			int sizeClass = 0;
+			while (sizeClass + 1 < m_classCount && m_sizes[sizeClass] < size) {
+				++sizeClass;
+			}
+			return sizeClass;
+		}
+
+#ifdef OFDEQUE_INDEXED_LINKS
+		/* the size class lives in the top bits of an index */
+		BufferRef indexOf(Buffer *buffer) {
+			if (buffer == NULL) {
+				return 0;
+			}
+			return ((BufferRef)buffer->m_sizeClass << ClassShift) | m_pPools[buffer->m_sizeClass]->indexOf(buffer);
+		}
+
+		Buffer *fromIndex(BufferRef index) {
+			return m_pPools[index >> ClassShift]->fromIndex(index & ((1u << ClassShift) - 1));
+		}
+#endif
+
+		/*
+		 * Retired buffers waiting for the reclaimer, in bytes.  Both
+		 * reclaimers free a buffer in the thread that retired it, so each
+		 * thread keeps its own count and peak.
+		 */
+		void noteRetired(Buffer *buffer, int tid) {
+			RetiredBytes &r = m_pRetired[tid].ui;
+			r.m_current += m_bytes[buffer->m_sizeClass];
+			r.m_peak = r.m_current > r.m_peak ? r.m_current : r.m_peak;
+		}
+
+		long getRetiredPeak(int tid) { return m_pRetired[tid].ui.m_peak; }
+
+		/* for RAllocator interface */
+		void *allocBlock(int tid) {
+			return alloc(0, tid);
+		}
+		void freeBlock(void *ptr, int tid) {
+			Buffer *buffer = (Buffer*)ptr;
+			m_pRetired[tid].ui.m_current -= m_bytes[buffer->m_sizeClass];
+			m_pPools[buffer->m_sizeClass]->free(buffer, tid);
+		}
+
+	private:
+		/* --- Inner Types --- */
+		struct RetiredBytes {
+			long m_current;
+			long m_peak;
+		};
+
+		/* --- Static Fields --- */
+		static const int MaxClasses = 16;
+		static const int ClassShift = 27;
+#ifdef OFDEQUE_INDEXED_LINKS
+		/* address space reserved per size class when links are 32-bit indices */
+		static const unsigned long ArenaBytes = 1ul << 36;
+#endif
+
+		/* --- Instance Fields --- */
+		BlockPool<Buffer> *m_pPools[MaxClasses];
+		int m_sizes[MaxClasses];
+		unsigned long m_bytes[MaxClasses];
+		int m_classCount;
+		bool m_edgeMap;
+		padded<RetiredBytes> *m_pRetired;
+	};
+
+	/* per side state of the adaptive buffer size policy */
+	struct SizePolicy {
+		std::atomic<int> m_sizeClass;
+		std::atomic<int> m_appends;
+		std::atomic<int> m_retires;
+	} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	/* per side ring of recently unlinked buffers, see linger */
+	struct LingerList {
+		std::atomic<unsigned> m_next;
+		std::atomic<Buffer*> m_pBuffers[OFDequeOptions::MaxLinger];
+	} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	/* per side reserve of buffers filled with that side's far type */
+	struct BufferReserve {
+		/* filled and claimed slots of m_pBuffers */
+		std::atomic<int> m_count;
+		std::atomic<Buffer*> m_pBuffers[OFDequeReserve::MaxDepth];
+	} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	/* state of a combiner request: what it asks for, then done */
+	enum RequestState {
+		REQUEST_IDLE = 0,
+		REQUEST_PUSH,
+		REQUEST_POP,
+		REQUEST_DONE
+	};
+
+	/*
+	 * A thread's operation on a combining side (-d hybrid=1).  The thread
+	 * sets m_value and publishes the kind in m_state; the combiner sets the
+	 * result and then REQUEST_DONE.
+	 */
+	struct CombineRequest {
+		std::atomic<int> m_state;
+		T m_value;
+		/* false if a bounded deque was full */
+		bool m_pushed;
+	};
+
+	/* per side flat-combining state, see combine */
+	struct Combiner {
+		/* operations on this side go through the combiner while set */
+		std::atomic<bool> m_active;
+		std::atomic<int> m_lock __attribute__ ((aligned(CACHE_LINE_SIZE)));
+		/* owned by the lock holder: passes and requests served since the
+		 * last switch decision, and the requests of the current round */
+		int m_passes;
+		int m_served;
+		int *m_pPushers;
+		int *m_pPoppers;
+		T *m_pValues;
+	} __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	/* a thread's operations and failed attempts on one side since its last switch decision */
+	struct ContentionWindow {
+		int m_ops;
+		int m_misses;
 	};
 
 	struct GlobalHint {
 		/* --- Constructors --- */
 		GlobalHint() noexcept { }
-		GlobalHint(Buffer *b, uint32_t u) :
-			m_pBuffer(b), m_count(u) { }
+		GlobalHint(BufferRef b, SlotWord u) :
+			m_buffer(b), m_count(u) { }
 		/* --- Instance Fields --- */
-		Buffer* m_pBuffer;
-		uint32_t m_count;
+		BufferRef m_buffer;
+		SlotWord m_count;
 	};
 
 	struct Edge {
@@ -129,56 +1173,166 @@ private:
 		int m_index;
 	};
 
+	/*
+	 * Edge a thread found on its last oracle call, with the count of the
+	 * global hint it was found under.  While that count is unchanged no
+	 * buffer has been retired since (see oracle), so m_pBuffer is still safe
+	 * to reserve and the edge is usually a few slots away.
+	 */
+	struct EdgeCache {
+		Buffer *m_pBuffer;
+		int m_index;
+		SlotWord m_count;
+	};
+
 	struct OracleResult {
 		/* --- Instance Fields --- */
 		GlobalHint m_hint;
 		Edge m_edge;
 	};
 
-	struct ThreadLog {
-		int m_stdPops, m_elimPops;
-		int m_stdPushes, m_elimPushes;
-		int m_oracleLoops;
-		int m_oracleInvokes;
-	};
+	typedef typename Stats::ThreadLog ThreadLog;
 
 	/* --- Instance Methods (Auxiliary) --- */
 
-	void retire(Buffer *buffer, int tid);
+	template<OFDequeTypes::Side S> void retire(Buffer *buffer, int tid);
+	void retireNow(Buffer *buffer, int tid);
+	template<OFDequeTypes::Side S> void linger(Buffer *buffer, int tid);
+	template<OFDequeTypes::Side S> Buffer *takeLingering(int tid);
+	inline void logEvent(OFDequeStats::Counter counter, int tid, int n = 1);
+	inline bool checkCas(bool success, OFDequeStats::Counter counter, int tid);
+	inline uint64_t elimClock();
+	inline void logElimination(const typename ElimTable<T>::ScanInfo &scan, bool eliminated, uint64_t started, int tid);
+	inline bool casPush(Buffer *buffer, int nearIndex, Slot nearSlot, int farIndex, Slot farSlot, const T &value, int tid);
+	inline Buffer *toBuffer(BufferRef ref);
+	inline BufferRef toRef(Buffer *buffer);
 	template<OFDequeTypes::Side S> T doPop(int tid);
-	template<OFDequeTypes::Side S> void doPush(const T &value, int tid);
+	template<OFDequeTypes::Side S> T popDirect(int tid);
+	template<OFDequeTypes::Side S> T doPeek(int tid);
+	template<OFDequeTypes::Side S> bool doPush(const T &value, int tid);
+	template<OFDequeTypes::Side S> bool pushDirect(const T &value, int tid);
+	template<OFDequeTypes::Side S> CombineRequest &combine(RequestState state, const T &value, int tid);
+	template<OFDequeTypes::Side S> void combinePass(int tid);
+	template<OFDequeTypes::Side S> inline void noteMiss(int tid);
+	template<OFDequeTypes::Side S> void noteContention(int tid);
+	template<OFDequeTypes::Side S> void pushOrWait(const T &value, int tid);
+	template<OFDequeTypes::Side S> T doPopWait(int tid, long timeoutUs);
+	inline void wakeWaiters(int count, int tid);
+	inline void countValues(long delta, int tid);
+	template<OFDequeTypes::Side S> int doPopN(T *outValues, int count, int tid);
+	template<OFDequeTypes::Side S> void doPushN(const T *values, int count, int tid);
+	template<OFDequeTypes::Side S> int popRun(T *outValues, int count, int tid);
+	template<OFDequeTypes::Side S> int pushRun(const T *values, int count, int tid);
 	template<OFDequeTypes::Side S> bool findEdge(Edge &outEdge, GlobalHint hint, int tid);
+	template<OFDequeTypes::Side S> bool findEdgeFrom(Edge &outEdge, GlobalHint hint, Buffer *buffer, int index, int hazSlot, int maxSteps, int tid);
+	template<OFDequeTypes::Side S> int edgeMapStart(Buffer *buffer, int index, int tid);
+	template<OFDequeTypes::Side S> inline void moveEdgeMark(Buffer *buffer, int from, int to);
+	template<OFDequeTypes::Side S> inline void moveLocalHint(Buffer *buffer, int delta, int index, int tid);
 	
 	template<OFDequeTypes::Side S> bool findActiveBuffer(Buffer **outBuffer, GlobalHint hint, int tid);
 
 	template<OFDequeTypes::Side S> OracleResult oracle(int tid);
 	template<OFDequeTypes::Side S> GlobalHint reserveHint(int slot, int tid);
 	template<OFDequeTypes::Side S> void updateHint(int tid);
-	template<OFDequeTypes::Side S> std::atomic<GlobalHint> &getGlobalHint();
+	template<OFDequeTypes::Side S> Atomic<GlobalHint> &getGlobalHint();
 	template<OFDequeTypes::Side S> padded<Buffer*> *getBufferCache();
+	template<OFDequeTypes::Side S> padded<EdgeCache> *getEdgeCache();
 	template<OFDequeTypes::Side S> ElimTable<T> *getElimTable();
+	template<OFDequeTypes::Side S> SizePolicy &getSizePolicy();
+	template<OFDequeTypes::Side S> void noteAppend();
+	template<OFDequeTypes::Side S> void noteRetire();
+	template<OFDequeTypes::Side S> BufferReserve &getBufferReserve();
+	template<OFDequeTypes::Side S> LingerList &getLingerList();
+	template<OFDequeTypes::Side S> Combiner &getCombiner();
+	template<OFDequeTypes::Side S> padded<CombineRequest> *getCombineRequests();
+	template<OFDequeTypes::Side S> padded<ContentionWindow> *getContentionWindows();
+	template<OFDequeTypes::Side S> Buffer *prepareBuffer(int sizeClass, int tid);
+	template<OFDequeTypes::Side S> Buffer *takeReserved(int tid);
+	template<OFDequeTypes::Side S> bool refillReserve(int tid);
+	template<OFDequeTypes::Side S> void refillAfterPop(int tid);
+	void runReserveHelper();
+	inline bool claimBuffer();
+	inline void releaseBuffer();
 
 	/* --- Static Methods (Auxiliary) --- */
 
-	template<OFDequeTypes::Side S> static constexpr int GetFarLinkIndex();
-	template<OFDequeTypes::Side S> static constexpr int GetNearLinkIndex();
-	template<OFDequeTypes::Side S> static constexpr int GetFarValueIndex();
-	template<OFDequeTypes::Side S> static constexpr int GetNearValueIndex();
+	static inline int ScanTypes(Buffer *buffer, int index, int step, unsigned stopTypes);
+	template<OFDequeTypes::Side S> static inline int GetFarLinkIndex(Buffer *buffer);
+	template<OFDequeTypes::Side S> static inline int GetNearLinkIndex(Buffer *buffer);
+	template<OFDequeTypes::Side S> static inline int GetFarValueIndex(Buffer *buffer);
+	template<OFDequeTypes::Side S> static inline int GetNearValueIndex(Buffer *buffer);
 	template<OFDequeTypes::Side S> static constexpr int GetFarDirection();
 	template<OFDequeTypes::Side S> std::atomic<int> &GetLocalHint(Buffer *buf);
 	template<OFDequeTypes::Side S> static constexpr OFDequeTypes::Type GetFarType();
 	template<OFDequeTypes::Side S> static constexpr OFDequeTypes::Type GetNearType();
 
+	/* --- Static Fields --- */
+
+	/* slots a cached edge may be away from the real one before the oracle falls back to a full search */
+	static const int EdgeCacheProbe = 8;
+	/* appends per side between adaptive size decisions */
+	static const int AdaptWindow = 8;
+	/* microseconds the reserve helper sleeps when both reserves are full */
+	static const int ReserveHelperSleep = 50;
+	/* pops a waiting pop tries before it parks */
+	static const int PopWaitSpins = 64;
+	/* spins a batch offer stays open for pops to claim from */
+	static const int BatchWindow = 256;
+	/* operations per thread and side between decisions to start combining */
+	static const int HybridWindow = 64;
+	/* combining passes per side between decisions to stop */
+	static const int CombineWindow = 64;
+	/* rounds of collecting requests in one combining pass */
+	static const int CombineRounds = 4;
+	/* spins a combiner request waits before it yields */
+	static const int CombineSpins = 64;
+
 	/* --- Instance Fields --- */
 
-	paddedAtomic<GlobalHint> m_leftGlobalHint __attribute__ ((aligned(CACHE_LINE_SIZE))); 
-	paddedAtomic<GlobalHint> m_rightGlobalHint __attribute__ ((aligned(CACHE_LINE_SIZE)));
+	PaddedAtomic<GlobalHint> m_leftGlobalHint __attribute__ ((aligned(CACHE_LINE_SIZE))); 
+	PaddedAtomic<GlobalHint> m_rightGlobalHint __attribute__ ((aligned(CACHE_LINE_SIZE)));
 	
 	padded<Buffer*> *m_pLeftBufferCache;
 	padded<Buffer*> *m_pRightBufferCache;
+
+	padded<EdgeCache> *m_pLeftEdgeCache;
+	padded<EdgeCache> *m_pRightEdgeCache;
+
+	/* per-thread xorshift state for sampled local hint writes */
+	padded<uint32_t> *m_pHintRandom;
 	
-	BlockPool<Buffer> *m_pBlockPool;
-	HazardTracker *m_pHazTracker;
+	SizePolicy m_leftSizePolicy;
+	SizePolicy m_rightSizePolicy;
+
+	BufferReserve m_leftReserve;
+	BufferReserve m_rightReserve;
+
+	LingerList m_leftLinger;
+	LingerList m_rightLinger;
+
+	Combiner m_leftCombiner;
+	Combiner m_rightCombiner;
+	padded<CombineRequest> *m_pLeftRequests;
+	padded<CombineRequest> *m_pRightRequests;
+	padded<ContentionWindow> *m_pLeftWindows;
+	padded<ContentionWindow> *m_pRightWindows;
+
+	std::thread m_reserveHelper;
+	std::atomic<bool> m_stopReserveHelper;
+
+	/* buffers linked into the chain, only counted when m_maxBuffers is set */
+	paddedAtomic<int> m_bufferCount __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	/* per thread values pushed less values popped, for size_approx */
+	paddedAtomic<long> *m_pSizeCounts;
+
+	/* pops parked (or about to park) on m_wakeSeq, the futex word pushes bump */
+	paddedAtomic<int> m_waiters __attribute__ ((aligned(CACHE_LINE_SIZE)));
+	paddedAtomic<int> m_wakeSeq __attribute__ ((aligned(CACHE_LINE_SIZE)));
+
+	BufferPool *m_pBufferPool;
+	Reclaimer *m_pReclaimer;
+	ContentionManager *m_pContention;
 	
 	ElimTable<T> *m_pLeftElimTable;
 	ElimTable<T> *m_pRightElimTable;
@@ -188,66 +1342,152 @@ private:
 	const T m_empty;
 	const int m_threadCount;
 	const int m_scanCountStart;
+	const OFDequeBufferSizes m_sizes;
+	const OFDequeReserve m_reserve;
+	const bool m_edgeCache;
+	const bool m_edgeMap;
+	const int m_maxBuffers;
+	const int m_linger;
+	const int m_hintPeriod;
+	const bool m_pairCas;
+	const bool m_batchElim;
+	const OFDequeHybrid m_hybrid;
 
 	/* --- Friends --- */
 
-	friend struct OFDequeUtils<OFDequeTypes::SIDE_LEFT, T, BufferSize, Elimination>;
-	friend struct OFDequeUtils<OFDequeTypes::SIDE_RIGHT, T, BufferSize, Elimination>;
+	friend struct OFDequeUtils<OFDequeTypes::SIDE_LEFT, T, Elimination, Stats, Reclaimer, ContentionManager>;
+	friend struct OFDequeUtils<OFDequeTypes::SIDE_RIGHT, T, Elimination, Stats, Reclaimer, ContentionManager>;
+	/* drives oracle() directly to measure edge search cost */
+	friend class EdgeSearchTest;
 };
 
-template<OFDequeTypes::Side S, typename T, int BufferSize, bool Elimination> struct OFDequeUtils {};
-template<typename T, int BufferSize, bool Elimination> struct OFDequeUtils<OFDequeTypes::Side::SIDE_LEFT, T, BufferSize, Elimination> {
-	static constexpr int GetFarLinkIndex() { return 0; }
-	static constexpr int GetNearLinkIndex() { return BufferSize - 1; }
-	static constexpr int GetFarValueIndex() { return 1; }
-	static constexpr int GetNearValueIndex() { return BufferSize - 2; }
+template<OFDequeTypes::Side S, typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> struct OFDequeUtils {};
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> struct OFDequeUtils<OFDequeTypes::Side::SIDE_LEFT, T, Elimination, Stats, Reclaimer, ContentionManager> {
+	static inline int GetFarLinkIndex(int size) { return 0; }
+	static inline int GetNearLinkIndex(int size) { return size - 1; }
+	static inline int GetFarValueIndex(int size) { return 1; }
+	static inline int GetNearValueIndex(int size) { return size - 2; }
 
 	static constexpr int GetFarDirection() { return -1; }
 	
 	static constexpr OFDequeTypes::Type GetFarType() { return OFDequeTypes::TYPE_LEFT; }
 	static constexpr OFDequeTypes::Type GetNearType() { return OFDequeTypes::TYPE_RIGHT; }
 
-	static std::atomic<typename OFDeque<T, BufferSize, Elimination>::GlobalHint> &GetGlobalHint(OFDeque<T, BufferSize, Elimination> *d) { return d->m_leftGlobalHint.ui; }
-	static std::atomic<int> &GetLocalHint(typename OFDeque<T, BufferSize, Elimination>::Buffer *buf) { return buf->m_leftLocalHint.ui; }
-	static padded<typename OFDeque<T, BufferSize, Elimination>::Buffer*> *GetBufferCache(OFDeque<T, BufferSize, Elimination> *d) { return d->m_pLeftBufferCache; }
-
-	static ElimTable<T> *GetElimTable(OFDeque<T, BufferSize, Elimination> *d) { return d->m_pLeftElimTable; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::template Atomic<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GlobalHint> &GetGlobalHint(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_leftGlobalHint.ui; }
+	static std::atomic<int> &GetLocalHint(typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *buf) { return buf->m_leftLocalHint.ui; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer*> *GetBufferCache(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pLeftBufferCache; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::EdgeCache> *GetEdgeCache(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pLeftEdgeCache; }
+
+	static ElimTable<T> *GetElimTable(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pLeftElimTable; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::SizePolicy &GetSizePolicy(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_leftSizePolicy; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::BufferReserve &GetBufferReserve(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_leftReserve; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::LingerList &GetLingerList(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_leftLinger; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Combiner &GetCombiner(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_leftCombiner; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::CombineRequest> *GetCombineRequests(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pLeftRequests; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::ContentionWindow> *GetContentionWindows(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pLeftWindows; }
 };
 
-template<typename T, int BufferSize, bool Elimination> struct OFDequeUtils<OFDequeTypes::Side::SIDE_RIGHT, T, BufferSize, Elimination> {
-	static constexpr int GetFarLinkIndex() { return BufferSize - 1; }
-	static constexpr int GetNearLinkIndex() { return 0; }
-	static constexpr int GetFarValueIndex() { return BufferSize - 2; }
-	static constexpr int GetNearValueIndex() { return 1; }
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> struct OFDequeUtils<OFDequeTypes::Side::SIDE_RIGHT, T, Elimination, Stats, Reclaimer, ContentionManager> {
+	static inline int GetFarLinkIndex(int size) { return size - 1; }
+	static inline int GetNearLinkIndex(int size) { return 0; }
+	static inline int GetFarValueIndex(int size) { return size - 2; }
+	static inline int GetNearValueIndex(int size) { return 1; }
 
 	static constexpr int GetFarDirection() { return 1; }
 
 	static constexpr OFDequeTypes::Type GetFarType() { return OFDequeTypes::TYPE_RIGHT; }
 	static constexpr OFDequeTypes::Type GetNearType() { return OFDequeTypes::TYPE_LEFT; }
 
-	static std::atomic<typename OFDeque<T, BufferSize, Elimination>::GlobalHint> &GetGlobalHint(OFDeque<T, BufferSize, Elimination> *d) { return d->m_rightGlobalHint.ui; }
-	static std::atomic<int> &GetLocalHint(typename OFDeque<T, BufferSize, Elimination>::Buffer *buf) { return buf->m_rightLocalHint.ui; }
-	static padded<typename OFDeque<T, BufferSize, Elimination>::Buffer*> *GetBufferCache(OFDeque<T, BufferSize, Elimination> *d) { return d->m_pRightBufferCache; }
-
-	static ElimTable<T> *GetElimTable(OFDeque<T, BufferSize, Elimination> *d) { return d->m_pRightElimTable; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::template Atomic<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GlobalHint> &GetGlobalHint(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_rightGlobalHint.ui; }
+	static std::atomic<int> &GetLocalHint(typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *buf) { return buf->m_rightLocalHint.ui; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer*> *GetBufferCache(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pRightBufferCache; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::EdgeCache> *GetEdgeCache(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pRightEdgeCache; }
+
+	static ElimTable<T> *GetElimTable(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pRightElimTable; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::SizePolicy &GetSizePolicy(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_rightSizePolicy; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::BufferReserve &GetBufferReserve(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_rightReserve; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::LingerList &GetLingerList(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_rightLinger; }
+	static typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Combiner &GetCombiner(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_rightCombiner; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::CombineRequest> *GetCombineRequests(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pRightRequests; }
+	static padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::ContentionWindow> *GetContentionWindows(OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager> *d) { return d->m_pRightWindows; }
 };
 
-template<int BufferSize, bool Elimination> class OFDequeFactory : public RContainerFactory {
-	OFDeque<int32_t, BufferSize, Elimination>* build(GlobalTestConfig* gtc){
-		return new OFDeque<int32_t, BufferSize, Elimination>(0, gtc->task_num, gtc->environment["glibc"]=="1");
+template<bool Elimination, typename Stats = OFDequeNoStats, typename Reclaimer = OFDequeHazards> class OFDequeFactory : public RContainerFactory {
+public:
+	/* buffers have defaultBufferSize slots unless -d bufsize is given */
+	OFDequeFactory(int defaultBufferSize = 512) : m_defaultBufferSize(defaultBufferSize) { }
+	/* the contention manager comes from -d cm=none|exp|polka|spinyield|announce (default none) */
+	RDeque* build(GlobalTestConfig* gtc){
+		std::string cm = gtc->environment.count("cm") ? gtc->environment["cm"] : "none";
+		if (cm == "none") {
+			return build<OFDequeNoBackoff>(gtc);
+		} else if (cm == "exp") {
+			return build<OFDequeExpBackoff>(gtc);
+		} else if (cm == "polka") {
+			return build<OFDequePolka>(gtc);
+		} else if (cm == "spinyield") {
+			return build<OFDequeSpinYield>(gtc);
+		} else if (cm == "announce") {
+			return build<OFDequeAnnounce>(gtc);
+		}
+		errexit("OFDeque contention manager must be one of none, exp, polka, spinyield, announce.");
+		return NULL;
+	}
+private:
+	template<typename ContentionManager> RDeque* build(GlobalTestConfig* gtc){
+		OFDequeOptions options = OFDequeOptions::FromEnvironment(gtc, m_defaultBufferSize);
+		/* a lingering buffer is only linked again once isReserved clears it, which epochs never do */
+		if (options.m_linger > 0 && !Reclaimer::ReservesBuffers) {
+			errexit("OFDeque linger needs hazard pointers, the _Epoch rideables cannot reuse buffers.");
+		}
+		return new OFDeque<int32_t, Elimination, Stats, Reclaimer, ContentionManager>(0, gtc->task_num, gtc->environment["glibc"]=="1", options);
 	}
+
+	int m_defaultBufferSize;
 };
 
-template<typename T, int BufferSize, bool Elimination>
-OFDeque<T, BufferSize, Elimination>::OFDeque(T empty, int threadCount, bool glibc) :
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::OFDeque(T empty, int threadCount, bool glibc, OFDequeOptions options) :
 	m_empty(empty),
 	m_threadCount(threadCount),
-	m_scanCountStart(threadCount) {
-
-	m_pBlockPool = new BlockPool<Buffer>(threadCount, glibc);
-
-	void *haz = memalign(CACHE_LINE_SIZE, sizeof(HazardTracker));
-	m_pHazTracker = new (haz) HazardTracker(threadCount, m_pBlockPool, 2, 2);
+	m_scanCountStart(threadCount),
+	m_sizes(options.m_sizes),
+	m_reserve(options.m_reserve),
+	m_edgeCache(options.m_edgeCache),
+	m_edgeMap(options.m_edgeMap),
+	m_maxBuffers(options.m_maxBuffers),
+	m_linger(options.m_linger),
+	m_hintPeriod(options.m_hintPeriod),
+	m_pairCas(options.m_pairCas),
+	m_batchElim(Elimination && options.m_batchElim),
+	m_hybrid(options.m_hybrid) {
+
+	const OFDequeBufferSizes &sizes = m_sizes;
+	const OFDequeReserve &reserve = m_reserve;
+
+	assert(sizes.m_min >= OFDequeBufferSizes::MinSize && sizes.m_min <= sizes.m_max);
+	assert(reserve.m_depth >= 0 && reserve.m_depth <= OFDequeReserve::MaxDepth);
+	assert(m_maxBuffers == 0 || m_maxBuffers >= OFDequeOptions::MinBuffers);
+	assert(m_linger >= 0 && m_linger <= OFDequeOptions::MaxLinger);
+	assert(m_linger == 0 || Reclaimer::ReservesBuffers);
+	assert(m_hintPeriod >= 1 && (m_hintPeriod & (m_hintPeriod - 1)) == 0);
+
+	/* one extra allocator thread for the reserve helper */
+	m_pBufferPool = new BufferPool(threadCount + 1, glibc, sizes, m_edgeMap);
+
+	void *reclaimer = memalign(CACHE_LINE_SIZE, sizeof(Reclaimer));
+	m_pReclaimer = new (reclaimer) Reclaimer(threadCount, m_pBufferPool);
+
+	m_pContention = new ContentionManager(threadCount, options.m_contention);
+
+	/* both sides start appending buffers of the initial size */
+	int initialClass = m_pBufferPool->getSizeClass(sizes.m_initial);
+	SizePolicy *policies[2] = { &m_leftSizePolicy, &m_rightSizePolicy };
+	for (int i = 0; i < 2; ++i) {
+		policies[i]->m_sizeClass.store(initialClass, std::memory_order_relaxed);
+		policies[i]->m_appends.store(0, std::memory_order_relaxed);
+		policies[i]->m_retires.store(0, std::memory_order_relaxed);
+	}
 
 	/* allocate left buffer cache */
 	m_pLeftBufferCache = (padded<Buffer*>*)memalign(CACHE_LINE_SIZE, sizeof(padded<Buffer*>) * threadCount);
@@ -261,74 +1501,725 @@ OFDeque<T, BufferSize, Elimination>::OFDeque(T empty, int threadCount, bool glib
 		m_pRightBufferCache[i].ui = NULL;
 	}
 
+	/* allocate edge caches */
+	m_pLeftEdgeCache = (padded<EdgeCache>*)memalign(CACHE_LINE_SIZE, sizeof(padded<EdgeCache>) * threadCount);
+	m_pRightEdgeCache = (padded<EdgeCache>*)memalign(CACHE_LINE_SIZE, sizeof(padded<EdgeCache>) * threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		m_pLeftEdgeCache[i].ui.m_pBuffer = NULL;
+		m_pRightEdgeCache[i].ui.m_pBuffer = NULL;
+	}
+
+	m_pSizeCounts = (paddedAtomic<long>*)memalign(CACHE_LINE_SIZE, sizeof(paddedAtomic<long>) * threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		m_pSizeCounts[i].ui.store(0, std::memory_order_relaxed);
+	}
+
+	/* seed the hint samplers */
+	m_pHintRandom = (padded<uint32_t>*)memalign(CACHE_LINE_SIZE, sizeof(padded<uint32_t>) * threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		m_pHintRandom[i].ui = 0x9e3779b9u * (i + 1);
+	}
+
 	/* allocate elimination tables */
 	void *elimTable;
 
 	elimTable = memalign(CACHE_LINE_SIZE, sizeof(ElimTable<T>));
-	m_pLeftElimTable = new (elimTable) ElimTable<T>(threadCount);
+	m_pLeftElimTable = new (elimTable) ElimTable<T>(threadCount, options.m_adaptiveElim, options.m_cpus, options.m_nearFirstElim);
 	
 	elimTable = memalign(CACHE_LINE_SIZE, sizeof(ElimTable<T>));
-	m_pRightElimTable = new (elimTable) ElimTable<T>(threadCount);
+	m_pRightElimTable = new (elimTable) ElimTable<T>(threadCount, options.m_adaptiveElim, options.m_cpus, options.m_nearFirstElim);
 
 	/* allocate initial buffer */
-	Buffer *buffer = m_pBlockPool->alloc(0);
+	Buffer *buffer = m_pBufferPool->alloc(initialClass, 0);
 
 	/* fill buffer (this will set local hint as well) */
-	buffer->fill(BufferSize / 2);
+	buffer->fill(buffer->m_size / 2);
 
 	/* point both global hints to this buffer */
-	m_leftGlobalHint.ui.store(GlobalHint(buffer, 0), std::memory_order_release);
-	m_rightGlobalHint.ui.store(GlobalHint(buffer, 0), std::memory_order_release);
+	m_leftGlobalHint.ui.store(GlobalHint(toRef(buffer), 0), std::memory_order_release);
+	m_rightGlobalHint.ui.store(GlobalHint(toRef(buffer), 0), std::memory_order_release);
 
 	m_pThreadLogs = (padded<ThreadLog>*)memalign(CACHE_LINE_SIZE, sizeof(padded<ThreadLog>) * threadCount);
 
 	for (int i = 0; i < threadCount; ++i) {
-		ThreadLog &log = m_pThreadLogs[i].ui;
-		log.m_elimPops = 0;
-		log.m_elimPushes = 0;
-		log.m_oracleInvokes = 0;
-		log.m_oracleLoops = 0;
+		m_pThreadLogs[i].ui = ThreadLog();
+	}
+
+	/* empty reserves, then fill them up front so the first appends find buffers */
+	BufferReserve *reserves[2] = { &m_leftReserve, &m_rightReserve };
+	for (int i = 0; i < 2; ++i) {
+		reserves[i]->m_count.store(0, std::memory_order_relaxed);
+		for (int j = 0; j < OFDequeReserve::MaxDepth; ++j) {
+			reserves[i]->m_pBuffers[j].store(NULL, std::memory_order_relaxed);
+		}
+	}
+	while (refillReserve<OFDequeTypes::SIDE_LEFT>(threadCount) | refillReserve<OFDequeTypes::SIDE_RIGHT>(threadCount)) { }
+
+	LingerList *lingers[2] = { &m_leftLinger, &m_rightLinger };
+	for (int i = 0; i < 2; ++i) {
+		lingers[i]->m_next.store(0, std::memory_order_relaxed);
+		for (int j = 0; j < OFDequeOptions::MaxLinger; ++j) {
+			lingers[i]->m_pBuffers[j].store(NULL, std::memory_order_relaxed);
+		}
+	}
+
+	/* both sides start out without combining */
+	Combiner *combiners[2] = { &m_leftCombiner, &m_rightCombiner };
+	for (int i = 0; i < 2; ++i) {
+		combiners[i]->m_active.store(false, std::memory_order_relaxed);
+		combiners[i]->m_lock.store(0, std::memory_order_relaxed);
+		combiners[i]->m_passes = 0;
+		combiners[i]->m_served = 0;
+		combiners[i]->m_pPushers = new int[threadCount];
+		combiners[i]->m_pPoppers = new int[threadCount];
+		combiners[i]->m_pValues = new T[threadCount];
+	}
+	m_pLeftRequests = (padded<CombineRequest>*)memalign(CACHE_LINE_SIZE, sizeof(padded<CombineRequest>) * threadCount);
+	m_pRightRequests = (padded<CombineRequest>*)memalign(CACHE_LINE_SIZE, sizeof(padded<CombineRequest>) * threadCount);
+	m_pLeftWindows = (padded<ContentionWindow>*)memalign(CACHE_LINE_SIZE, sizeof(padded<ContentionWindow>) * threadCount);
+	m_pRightWindows = (padded<ContentionWindow>*)memalign(CACHE_LINE_SIZE, sizeof(padded<ContentionWindow>) * threadCount);
+	for (int i = 0; i < threadCount; ++i) {
+		m_pLeftRequests[i].ui.m_state.store(REQUEST_IDLE, std::memory_order_relaxed);
+		m_pRightRequests[i].ui.m_state.store(REQUEST_IDLE, std::memory_order_relaxed);
+		m_pLeftWindows[i].ui.m_ops = m_pLeftWindows[i].ui.m_misses = 0;
+		m_pRightWindows[i].ui.m_ops = m_pRightWindows[i].ui.m_misses = 0;
+	}
+
+	m_stopReserveHelper.store(false, std::memory_order_relaxed);
+	m_waiters.ui.store(0, std::memory_order_relaxed);
+	m_wakeSeq.ui.store(0, std::memory_order_relaxed);
+	m_bufferCount.ui.store(1, std::memory_order_relaxed);
+	if (reserve.m_helper) {
+		m_reserveHelper = std::thread(&OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::runReserveHelper, this);
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
-OFDeque<T, BufferSize, Elimination>::~OFDeque() {
-	// delete m_pBlockPool;
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::~OFDeque() {
+	if (m_reserveHelper.joinable()) {
+		m_stopReserveHelper.store(true, std::memory_order_release);
+		m_reserveHelper.join();
+	}
+	// delete m_pBufferPool;
   
-  free(m_pHazTracker);
+  m_pReclaimer->~Reclaimer();
+  free(m_pReclaimer);
+  delete m_pContention;
   free(m_pLeftBufferCache);
   free(m_pRightBufferCache);
+  free(m_pLeftEdgeCache);
+  free(m_pRightEdgeCache);
+  free(m_pHintRandom);
+  free(m_pSizeCounts);
+  m_pLeftElimTable->~ElimTable<T>();
+  m_pRightElimTable->~ElimTable<T>();
   free(m_pLeftElimTable);
   free(m_pRightElimTable);
   free(m_pThreadLogs);
+  free(m_pLeftRequests);
+  free(m_pRightRequests);
+  free(m_pLeftWindows);
+  free(m_pRightWindows);
+  Combiner *combiners[2] = { &m_leftCombiner, &m_rightCombiner };
+  for (int i = 0; i < 2; ++i) {
+    delete[] combiners[i]->m_pPushers;
+    delete[] combiners[i]->m_pPoppers;
+    delete[] combiners[i]->m_pValues;
+  }
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::left_push(T value, int tid) {
+	pushOrWait<OFDequeTypes::SIDE_LEFT>(value, tid);
+	countValues(1, tid);
+	wakeWaiters(1, tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::right_push(T value, int tid) {
+	pushOrWait<OFDequeTypes::SIDE_RIGHT>(value, tid);
+	countValues(1, tid);
+	wakeWaiters(1, tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::left_pop(int tid) {
+	T value = doPop<OFDequeTypes::SIDE_LEFT>(tid);
+	if (!(value == m_empty)) {
+		countValues(-1, tid);
+	}
+	return value;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::right_pop(int tid) {
+	T value = doPop<OFDequeTypes::SIDE_RIGHT>(tid);
+	if (!(value == m_empty)) {
+		countValues(-1, tid);
+	}
+	return value;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::peek_left(int tid) {
+	return doPeek<OFDequeTypes::SIDE_LEFT>(tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::peek_right(int tid) {
+	return doPeek<OFDequeTypes::SIDE_RIGHT>(tid);
+}
+
+/*
+ * Approximate size without touching a slot or a shared line: the sum of
+ * the threads' counts of values pushed less values popped, each written
+ * only by its own thread (see countValues).  With no operation in flight
+ * this is exact; an operation in flight is counted once it has returned.
+ * It is never negative.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+long OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::size_approx(int tid) {
+	long size = 0;
+	for (int i = 0; i < m_threadCount; ++i) {
+		size += m_pSizeCounts[i].ui.load(std::memory_order_relaxed);
+	}
+	return size > 0 ? size : 0;
+}
+
+/*
+ * Bounded mode guarantees room for the values of every linked buffer but
+ * the two ends, which may be almost empty, at the smallest buffer size.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+long OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::min_capacity() {
+	if (m_maxBuffers == 0) {
+		return LONG_MAX;
+	}
+	return (long)(m_maxBuffers - 2) * (m_sizes.m_min - 2);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::left_pop_wait(int tid, long timeoutUs) {
+	T value = doPopWait<OFDequeTypes::SIDE_LEFT>(tid, timeoutUs);
+	if (!(value == m_empty)) {
+		countValues(-1, tid);
+	}
+	return value;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::right_pop_wait(int tid, long timeoutUs) {
+	T value = doPopWait<OFDequeTypes::SIDE_RIGHT>(tid, timeoutUs);
+	if (!(value == m_empty)) {
+		countValues(-1, tid);
+	}
+	return value;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDequeTypes::PushResult OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::try_left_push(T value, int tid) {
+	if (!doPush<OFDequeTypes::SIDE_LEFT>(value, tid)) {
+		return OFDequeTypes::FULL;
+	}
+	countValues(1, tid);
+	wakeWaiters(1, tid);
+	return OFDequeTypes::PUSHED;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDequeTypes::PushResult OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::try_right_push(T value, int tid) {
+	if (!doPush<OFDequeTypes::SIDE_RIGHT>(value, tid)) {
+		return OFDequeTypes::FULL;
+	}
+	countValues(1, tid);
+	wakeWaiters(1, tid);
+	return OFDequeTypes::PUSHED;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::left_push_n(const T *values, int count, int tid) {
+	doPushN<OFDequeTypes::SIDE_LEFT>(values, count, tid);
+	countValues(count, tid);
+	wakeWaiters(count, tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::right_push_n(const T *values, int count, int tid) {
+	doPushN<OFDequeTypes::SIDE_RIGHT>(values, count, tid);
+	countValues(count, tid);
+	wakeWaiters(count, tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::left_pop_n(T *outValues, int count, int tid) {
+	int popped = doPopN<OFDequeTypes::SIDE_LEFT>(outValues, count, tid);
+	countValues(-popped, tid);
+	return popped;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::right_pop_n(T *outValues, int count, int tid) {
+	int popped = doPopN<OFDequeTypes::SIDE_RIGHT>(outValues, count, tid);
+	countValues(-popped, tid);
+	return popped;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPushN(const T *values, int count, int tid) {
+	int pushed = 0;
+	if (m_batchElim) {
+		/* pops took the first values; push the rest in order */
+		pushed = getElimTable<S>()->handOffBatch(values, count, BatchWindow, tid);
+		logEvent(OFDequeStats::BATCH_HANDOFFS, tid, pushed);
+	}
+	while (pushed < count) {
+		int run = pushRun<S>(values + pushed, count - pushed, tid);
+		if (run == 0) {
+			/* edge is on a border or contended: take the general path for one value */
+			pushOrWait<S>(values[pushed], tid);
+			run = 1;
+		}
+		pushed += run;
+	}
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPopN(T *outValues, int count, int tid) {
+	int popped = 0;
+	while (popped < count) {
+		int run = popRun<S>(outValues + popped, count - popped, tid);
+		if (run == 0) {
+			/* edge is on a border, contended or possibly empty: take the general path for one value */
+			T value = doPop<S>(tid);
+			if (value == m_empty) {
+				break;
+			}
+			outValues[popped] = value;
+			run = 1;
+		}
+		popped += run;
+	}
+	refillAfterPop<S>(tid);
+	return popped;
+}
+
+/*
+ * Interior push of up to @count values from a single oracle result: each
+ * value goes in with the usual casSafe(near)/casValue(far) pair and the
+ * slot just filled becomes the next near slot.  The run stops at the first
+ * failed CAS or when the edge reaches the buffer border.  The local hint is
+ * moved once for the whole run.  Returns the number of values pushed.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::pushRun(const T *values, int count, int tid) {
+	using namespace OFDequeTypes;
+
+	OracleResult oracleResult = oracle<S>(tid);
+	Buffer *buffer = oracleResult.m_edge.m_pBuffer;
+	int nearIndex = oracleResult.m_edge.m_index;
+
+	int pushed = 0;
+	while (pushed < count && nearIndex != GetFarValueIndex<S>(buffer)) {
+		int farIndex = nearIndex + GetFarDirection<S>();
+
+		Slot nearSlot = buffer->slot(nearIndex).load(std::memory_order_acquire);
+		Slot farSlot = buffer->slot(farIndex).load(std::memory_order_acquire);
+
+		Type nearType = (Type)nearSlot.m_type;
+		if (nearType == GetFarType<S>() || nearType == TYPE_SEALED || farSlot.m_type != GetFarType<S>()) {
+			break;
+		}
+		if (nearIndex == GetNearLinkIndex<S>(buffer) && nearType != GetNearType<S>()) {
+			break;
+		}
+
+		if (!casPush(buffer, nearIndex, nearSlot, farIndex, farSlot, values[pushed], tid)) {
+			break;
+		}
+		++pushed;
+		nearIndex = farIndex;
+	}
+
+	if (pushed > 0) {
+		moveLocalHint<S>(buffer, pushed * GetFarDirection<S>(), nearIndex, tid);
+		moveEdgeMark<S>(buffer, nearIndex - pushed * GetFarDirection<S>(), nearIndex);
+		logEvent(OFDequeStats::STD_PUSHES, tid, pushed);
+	}
+	m_pReclaimer->clearAll(tid);
+	return pushed;
+}
+
+/*
+ * Interior pop of up to @count values from a single oracle result, the
+ * mirror image of pushRun: each value comes out with casSafe(far)/
+ * casType(near) and the emptied slot becomes the next far slot.  The run
+ * stops at the first failed CAS, a non-value near slot (possibly empty) or
+ * the near link.  Returns the number of values popped.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::popRun(T *outValues, int count, int tid) {
+	using namespace OFDequeTypes;
+
+	OracleResult oracleResult = oracle<S>(tid);
+	Buffer *buffer = oracleResult.m_edge.m_pBuffer;
+	int nearIndex = oracleResult.m_edge.m_index;
+
+	int popped = 0;
+	if (nearIndex != GetFarValueIndex<S>(buffer)) {
+		while (popped < count && nearIndex != GetNearLinkIndex<S>(buffer)) {
+			int farIndex = nearIndex + GetFarDirection<S>();
+
+			Slot nearSlot = buffer->slot(nearIndex).load(std::memory_order_acquire);
+			Slot farSlot = buffer->slot(farIndex).load(std::memory_order_acquire);
+
+			if (nearSlot.m_type != TYPE_VALUE || farSlot.m_type != GetFarType<S>()) {
+				break;
+			}
+
+			if (!checkCas(buffer->casSafe(farIndex, farSlot), OFDequeStats::CAS_FAILS_SAFE, tid) || !checkCas(buffer->casType(nearIndex, nearSlot, GetFarType<S>()), OFDequeStats::CAS_FAILS_TYPE, tid)) {
+				break;
+			}
+			outValues[popped++] = nearSlot.m_value;
+			nearIndex -= GetFarDirection<S>();
+		}
+	}
+
+	if (popped > 0) {
+		moveLocalHint<S>(buffer, -popped * GetFarDirection<S>(), nearIndex, tid);
+		moveEdgeMark<S>(buffer, nearIndex + popped * GetFarDirection<S>(), nearIndex);
+		logEvent(OFDequeStats::STD_POPS, tid, popped);
+	}
+	m_pReclaimer->clearAll(tid);
+	return popped;
+}
+
+/*
+ * Pop that waits for a value: PopWaitSpins ordinary pops first, then the
+ * thread registers in m_waiters and parks on the m_wakeSeq futex until a
+ * push bumps it or @timeoutUs microseconds (no limit if negative) have
+ * passed.  Each round reads m_wakeSeq before it pops, so a push that lands
+ * after the failed pop changes the word and the futex wait returns at
+ * once.  Returns the empty value only on timeout.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPopWait(int tid, long timeoutUs) {
+	T value;
+	for (int i = 0; i < PopWaitSpins; ++i) {
+		value = doPop<S>(tid);
+		if (!(value == m_empty)) {
+			return value;
+		}
+#if defined(__i386__) || defined(__x86_64__)
+		__builtin_ia32_pause();
+#endif
+	}
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	if (timeoutUs >= 0) {
+		deadline.tv_sec += timeoutUs / 1000000;
+		deadline.tv_nsec += (timeoutUs % 1000000) * 1000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+	}
+
+	m_waiters.ui.fetch_add(1, std::memory_order_seq_cst);
+	for (;;) {
+		int seq = m_wakeSeq.ui.load(std::memory_order_seq_cst);
+		value = doPop<S>(tid);
+		if (!(value == m_empty)) {
+			break;
+		}
+
+		struct timespec remaining, *timeout = NULL;
+		if (timeoutUs >= 0) {
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			long long ns = (deadline.tv_sec - now.tv_sec) * 1000000000ll + (deadline.tv_nsec - now.tv_nsec);
+			if (ns <= 0) {
+				break;
+			}
+			remaining.tv_sec = ns / 1000000000;
+			remaining.tv_nsec = ns % 1000000000;
+			timeout = &remaining;
+		}
+		logEvent(OFDequeStats::PARKS, tid);
+		syscall(SYS_futex, reinterpret_cast<int*>(&m_wakeSeq.ui), FUTEX_WAIT_PRIVATE, seq, timeout, NULL, 0);
+	}
+	m_waiters.ui.fetch_sub(1, std::memory_order_relaxed);
+	return value;
+}
+
+/*
+ * Adds @delta to the calling thread's count of values in the deque.  Only
+ * the thread itself writes its count, so a plain load and store on its own
+ * line do, without a locked instruction.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::countValues(long delta, int tid) {
+	std::atomic<long> &count = m_pSizeCounts[tid].ui;
+	count.store(count.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/*
+ * Wakes up to @count parked pops after a push.  With no waiters this is a
+ * single load: on x86 the locked CAS that completed the push already
+ * orders it after the push, as the waiter's fetch_add orders its
+ * registration before its pop, so one of the two sees the other.  Other
+ * targets need the fence.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::wakeWaiters(int count, int tid) {
+#if !defined(__i386__) && !defined(__x86_64__)
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+	if (m_waiters.ui.load(std::memory_order_seq_cst) == 0) {
+		return;
+	}
+	m_wakeSeq.ui.fetch_add(1, std::memory_order_seq_cst);
+	logEvent(OFDequeStats::WAKES, tid);
+	syscall(SYS_futex, reinterpret_cast<int*>(&m_wakeSeq.ui), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/*
+ * Push that waits for room: with -d maxbuffers a push that would have to
+ * append past the limit yields until pops have unlinked a buffer.  This is
+ * the backpressure left_push and right_push put on producers.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::pushOrWait(const T &value, int tid) {
+	while (!doPush<S>(value, tid)) {
+		std::this_thread::yield();
+	}
+}
+
+/*
+ * Push on side S.  With -d hybrid=1 the push goes through the side's
+ * combiner while it is combining, and otherwise counts towards the thread's
+ * decision to start combining.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPush(const T &value, int tid) {
+	if (!m_hybrid.m_enabled) {
+		return pushDirect<S>(value, tid);
+	}
+	if (getCombiner<S>().m_active.load(std::memory_order_relaxed)) {
+		return combine<S>(REQUEST_PUSH, value, tid).m_pushed;
+	}
+	bool pushed = pushDirect<S>(value, tid);
+	noteContention<S>(tid);
+	return pushed;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPop(int tid) {
+	if (!m_hybrid.m_enabled) {
+		return popDirect<S>(tid);
+	}
+	if (getCombiner<S>().m_active.load(std::memory_order_relaxed)) {
+		return combine<S>(REQUEST_POP, m_empty, tid).m_value;
+	}
+	T value = popDirect<S>(tid);
+	noteContention<S>(tid);
+	return value;
 }
 
-template<typename T, int BufferSize, bool Elimination>
-void OFDeque<T, BufferSize, Elimination>::left_push(T value, int tid) {
-	doPush<OFDequeTypes::SIDE_LEFT>(value, tid);
+/*
+ * Flat combining for a contended side.  The thread publishes its request
+ * and waits for it to be done; whenever the side's combiner lock is free
+ * it takes it and serves every published request itself, so a request is
+ * served even if the side stops combining meanwhile.  Only the combiner
+ * works on this end of the deque, through the usual lock-free operations,
+ * so its CASes rarely fail and the end's cache lines stay in one core.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::CombineRequest &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::combine(RequestState state, const T &value, int tid) {
+	Combiner &combiner = getCombiner<S>();
+	CombineRequest &request = getCombineRequests<S>()[tid].ui;
+	request.m_value = value;
+	request.m_state.store(state, std::memory_order_release);
+
+	for (int n = 0; request.m_state.load(std::memory_order_acquire) != REQUEST_DONE; ++n) {
+		if (combiner.m_lock.load(std::memory_order_relaxed) == 0 && combiner.m_lock.exchange(1, std::memory_order_acquire) == 0) {
+			/* the last combiner may have served the request before releasing the lock */
+			if (request.m_state.load(std::memory_order_acquire) != REQUEST_DONE) {
+				combinePass<S>(tid);
+			}
+			combiner.m_lock.store(0, std::memory_order_release);
+		} else if (n >= CombineSpins) {
+			std::this_thread::yield();
+		} else {
+#if defined(__i386__) || defined(__x86_64__)
+			__builtin_ia32_pause();
+#endif
+		}
+	}
+	request.m_state.store(REQUEST_IDLE, std::memory_order_relaxed);
+
+	/* misses the thread made as combiner say nothing about direct operations */
+	ContentionWindow &window = getContentionWindows<S>()[tid].ui;
+	window.m_ops = 0;
+	window.m_misses = 0;
+	return request;
 }
 
-template<typename T, int BufferSize, bool Elimination>
-void OFDeque<T, BufferSize, Elimination>::right_push(T value, int tid) {
-	doPush<OFDequeTypes::SIDE_RIGHT>(value, tid);
+/*
+ * One combining pass, under side S's combiner lock: up to CombineRounds
+ * rounds of collecting the published requests.  All of them are pending at
+ * once, so a push and a pop of the same round may meet at the end: the pop
+ * returns the pushed value and neither touches the deque.  The remaining
+ * pushes go in with pushRun, the remaining pops come out with popRun, and
+ * single operations take over where a run stops at a border.  Every
+ * CombineWindow passes the side stops combining if the passes served
+ * fewer than -d hybrid_off requests each.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::combinePass(int tid) {
+	Combiner &combiner = getCombiner<S>();
+	padded<CombineRequest> *requests = getCombineRequests<S>();
+	int served = 0;
+
+	for (int round = 0; round < CombineRounds; ++round) {
+		int pushes = 0;
+		int pops = 0;
+		for (int i = 0; i < m_threadCount; ++i) {
+			int state = requests[i].ui.m_state.load(std::memory_order_acquire);
+			if (state == REQUEST_PUSH) {
+				combiner.m_pPushers[pushes++] = i;
+			} else if (state == REQUEST_POP) {
+				combiner.m_pPoppers[pops++] = i;
+			}
+		}
+		if (pushes + pops == 0) {
+			break;
+		}
+		served += pushes + pops;
+
+		/* pair pushes with pops */
+		while (pushes > 0 && pops > 0) {
+			CombineRequest &push = requests[combiner.m_pPushers[--pushes]].ui;
+			CombineRequest &pop = requests[combiner.m_pPoppers[--pops]].ui;
+			pop.m_value = push.m_value;
+			push.m_pushed = true;
+			push.m_state.store(REQUEST_DONE, std::memory_order_release);
+			pop.m_state.store(REQUEST_DONE, std::memory_order_release);
+		}
+
+		/* pushes left over */
+		for (int i = 0; i < pushes; ++i) {
+			combiner.m_pValues[i] = requests[combiner.m_pPushers[i]].ui.m_value;
+		}
+		for (int done = 0; done < pushes; ) {
+			int run = pushRun<S>(combiner.m_pValues + done, pushes - done, tid);
+			for (int i = done; i < done + run; ++i) {
+				requests[combiner.m_pPushers[i]].ui.m_pushed = true;
+			}
+			if (run == 0) {
+				/* a full bounded deque fails the push; its thread yields and asks again */
+				requests[combiner.m_pPushers[done]].ui.m_pushed = pushDirect<S>(combiner.m_pValues[done], tid);
+				run = 1;
+			}
+			for (int i = done; i < done + run; ++i) {
+				requests[combiner.m_pPushers[i]].ui.m_state.store(REQUEST_DONE, std::memory_order_release);
+			}
+			done += run;
+		}
+
+		/* pops left over; once one finds the deque empty, so do the rest */
+		for (int done = 0; done < pops; ) {
+			int run = popRun<S>(combiner.m_pValues, pops - done, tid);
+			for (int i = 0; i < run; ++i) {
+				requests[combiner.m_pPoppers[done + i]].ui.m_value = combiner.m_pValues[i];
+			}
+			if (run == 0) {
+				T value = popDirect<S>(tid);
+				requests[combiner.m_pPoppers[done]].ui.m_value = value;
+				run = 1;
+				if (value == m_empty) {
+					for (int i = done + 1; i < pops; ++i) {
+						requests[combiner.m_pPoppers[i]].ui.m_value = m_empty;
+					}
+					run = pops - done;
+				}
+			}
+			for (int i = done; i < done + run; ++i) {
+				requests[combiner.m_pPoppers[i]].ui.m_state.store(REQUEST_DONE, std::memory_order_release);
+			}
+			done += run;
+		}
+		if (pops > 0) {
+			refillAfterPop<S>(tid);
+		}
+	}
+
+	logEvent(OFDequeStats::COMBINE_PASSES, tid);
+	logEvent(OFDequeStats::COMBINED_OPS, tid, served);
+	combiner.m_served += served;
+	if (++combiner.m_passes >= CombineWindow) {
+		if (combiner.m_served < m_hybrid.m_off * combiner.m_passes) {
+			combiner.m_active.store(false, std::memory_order_relaxed);
+			logEvent(OFDequeStats::COMBINE_STOPS, tid);
+		}
+		combiner.m_passes = 0;
+		combiner.m_served = 0;
+	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
-T OFDeque<T, BufferSize, Elimination>::left_pop(int tid) {
-	return doPop<OFDequeTypes::SIDE_LEFT>(tid);
+/* a failed attempt (backoff or oracle restart) on side S, for the -d hybrid=1 decision */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::noteMiss(int tid) {
+	if (m_hybrid.m_enabled) {
+		getContentionWindows<S>()[tid].ui.m_misses++;
+	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
-T OFDeque<T, BufferSize, Elimination>::right_pop(int tid) {
-	return doPop<OFDequeTypes::SIDE_RIGHT>(tid);
+/*
+ * Every HybridWindow direct operations on a side, a thread starts the
+ * side's combiner if it failed at least -d hybrid_on attempts per 100 of
+ * them.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::noteContention(int tid) {
+	ContentionWindow &window = getContentionWindows<S>()[tid].ui;
+	if (++window.m_ops < HybridWindow) {
+		return;
+	}
+	if (window.m_misses * 100 >= m_hybrid.m_on * window.m_ops) {
+		Combiner &combiner = getCombiner<S>();
+		if (!combiner.m_active.load(std::memory_order_relaxed) && !combiner.m_active.exchange(true, std::memory_order_relaxed)) {
+			logEvent(OFDequeStats::COMBINE_STARTS, tid);
+		}
+	}
+	window.m_ops = 0;
+	window.m_misses = 0;
 }
 
-template<typename T, int BufferSize, bool Elimination>
+/*
+ * Returns false, without pushing, only in bounded mode when the push needed
+ * a new buffer and the chain already has m_maxBuffers of them.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-void OFDeque<T, BufferSize, Elimination>::doPush(const T &value, int tid) {
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::pushDirect(const T &value, int tid) {
 	using namespace OFDequeTypes;
 	
 	int backoffScanCount = m_scanCountStart;
+	bool pushed = true;
+	m_pContention->begin(tid);
 	if (Elimination) {
 		getElimTable<S>()->insertPush(value, tid);
 	}
@@ -346,53 +2237,61 @@ void OFDeque<T, BufferSize, Elimination>::doPush(const T &value, int tid) {
 		int nearIndex = oracleResult.m_edge.m_index;
 		int farIndex = nearIndex + GetFarDirection<S>();
 
-		Slot nearSlot = buffer->m_pSlots[nearIndex].load(std::memory_order_acquire);
-		Slot farSlot = buffer->m_pSlots[farIndex].load(std::memory_order_acquire);
+		Slot nearSlot = buffer->slot(nearIndex).load(std::memory_order_acquire);
+		Slot farSlot = buffer->slot(farIndex).load(std::memory_order_acquire);
 
 		Type nearType = (Type)nearSlot.m_type;
 		Type farType = (Type)farSlot.m_type;
 
 		/* check oracle edge */
-		if (nearType == GetFarType<S>() || (nearType == TYPE_SEALED && nearIndex != GetFarValueIndex<S>())) {
+		if (nearType == GetFarType<S>() || (nearType == TYPE_SEALED && nearIndex != GetFarValueIndex<S>(buffer))) {
 			goto backoff;
     }
 
-		if (farIndex != GetFarLinkIndex<S>()) {
+		if (farIndex != GetFarLinkIndex<S>(buffer)) {
 			if (farType != GetFarType<S>()) {
 				goto backoff;
 			}
 		}
-		if (nearIndex == GetNearLinkIndex<S>()) {
+		if (nearIndex == GetNearLinkIndex<S>(buffer)) {
 			if (nearType != GetNearType<S>()) {
 				goto backoff;
 			}
 		}
 
-		if (nearIndex != GetFarValueIndex<S>()) {
+		if (nearIndex != GetFarValueIndex<S>(buffer)) {
 			/* interior push */
-			if (buffer->casSafe(nearIndex, nearSlot)) {
-				if (buffer->casValue(farIndex, farSlot, value)) {
-					/* update interior hint */
-					GetLocalHint<S>(buffer).fetch_add(GetFarDirection<S>(), std::memory_order_acq_rel);
-					goto out;
-				}
+			if (casPush(buffer, nearIndex, nearSlot, farIndex, farSlot, value, tid)) {
+				/* update interior hint */
+				moveLocalHint<S>(buffer, GetFarDirection<S>(), farIndex, tid);
+				moveEdgeMark<S>(buffer, nearIndex, farIndex);
+				logEvent(OFDequeStats::STD_PUSHES, tid);
+				goto out;
 			}
 		} else {
 			/* either straddling or boundary */
 			if (farType == GetFarType<S>()) {
 				/* append */
+				if (m_maxBuffers > 0 && !claimBuffer()) {
+					/* full; the value left the elimination table with removePush above */
+					logEvent(OFDequeStats::FULLS, tid);
+					pushed = false;
+					goto out;
+				}
+
 				/* grab new buffer from cache */
 				Buffer *newBuffer = getBufferCache<S>()[tid].ui;
+				if (newBuffer == NULL && m_linger > 0) {
+					newBuffer = takeLingering<S>(tid);
+				}
 				if (newBuffer == NULL) {
-					/* setup new buffer if needed */
-					newBuffer = m_pBlockPool->alloc(tid);
-					newBuffer->m_leftLocalHint.ui.store(GetNearValueIndex<S>(), std::memory_order_relaxed);
-					newBuffer->m_rightLocalHint.ui.store(GetNearValueIndex<S>(), std::memory_order_relaxed);
-
-					for (int i = 0; i < BufferSize; ++i) {
-						Slot s;
-						s.m_type = GetFarType<S>();
-						newBuffer->m_pSlots[i].store(s, std::memory_order_relaxed);
+					/* take a prepared buffer from the reserve, or set one up if it is empty */
+					newBuffer = takeReserved<S>(tid);
+					if (newBuffer == NULL) {
+						newBuffer = prepareBuffer<S>(getSizePolicy<S>().m_sizeClass.load(std::memory_order_relaxed), tid);
+						logEvent(OFDequeStats::INLINE_INITS, tid);
+					} else {
+						logEvent(OFDequeStats::RESERVE_TAKES, tid);
 					}
 
 					getBufferCache<S>()[tid].ui = newBuffer;
@@ -400,53 +2299,66 @@ void OFDeque<T, BufferSize, Elimination>::doPush(const T &value, int tid) {
 
 				/* pre-insert link and near value node with @value */
 				Slot s1;
-				s1.m_pLink = buffer;
+				s1.m_link = toRef(buffer);
 				s1.m_type = TYPE_VALUE;
 
 				Slot s2;
 				s2.m_value = value;
 				s2.m_type = TYPE_VALUE;
 
-				newBuffer->m_pSlots[GetNearLinkIndex<S>()].store(s1, std::memory_order_relaxed);
-				newBuffer->m_pSlots[GetNearValueIndex<S>()].store(s2, std::memory_order_relaxed);
+				newBuffer->slot(GetNearLinkIndex<S>(newBuffer)).store(s1, std::memory_order_relaxed);
+				newBuffer->slot(GetNearValueIndex<S>(newBuffer)).store(s2, std::memory_order_relaxed);
 
 				/* try append */
-				if (buffer->casSafe(nearIndex, nearSlot)) {
-					if (buffer->casLink(farIndex, farSlot, newBuffer)) {
+				if (checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+					if (checkCas(buffer->casLink(farIndex, farSlot, toRef(newBuffer)), OFDequeStats::CAS_FAILS_LINK, tid)) {
 						/* clear buffer cache */
 						getBufferCache<S>()[tid].ui = NULL;
+						noteAppend<S>();
 						/* update global hint */
-						getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(newBuffer, oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
+						getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(toRef(newBuffer), oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
+						logEvent(OFDequeStats::STD_PUSHES, tid);
+						logEvent(OFDequeStats::APPENDS, tid);
 						goto out;
 					}
 				}
+				if (m_maxBuffers > 0) {
+					releaseBuffer();
+				}
 			} else {
 				/* either straddling push or help remove sealed buffer */
-				Buffer *neighbor = farSlot.m_pLink;
-				Slot reachingSlot = neighbor->m_pSlots[GetNearValueIndex<S>()].load(std::memory_order_acquire);
+				Buffer *neighbor = toBuffer(farSlot.m_link);
+				Slot reachingSlot = neighbor->slot(GetNearValueIndex<S>(neighbor)).load(std::memory_order_acquire);
 
 				/* make sure far neighbor points back to buffer */
-				Slot backSlot = neighbor->m_pSlots[GetNearLinkIndex<S>()].load(std::memory_order_acquire);
+				Slot backSlot = neighbor->slot(GetNearLinkIndex<S>(neighbor)).load(std::memory_order_acquire);
 
-				if (backSlot.m_pLink != buffer) {
+				if (backSlot.m_link != toRef(buffer)) {
 					goto backoff;
         }
 
 				Type reachingType = (Type)reachingSlot.m_type;
 				if (reachingType == GetFarType<S>()) {
 					/* straddling push */
-					if (buffer->casSafe(nearIndex, nearSlot)) {
-						if (neighbor->casValue(GetNearValueIndex<S>(), reachingSlot, value)) {
+					if (checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+						if (checkCas(neighbor->casValue(GetNearValueIndex<S>(neighbor), reachingSlot, value), OFDequeStats::CAS_FAILS_VALUE, tid)) {
 							/* update global hint */
-							getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(neighbor, oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
+							getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(toRef(neighbor), oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
+							logEvent(OFDequeStats::STD_PUSHES, tid);
+							logEvent(OFDequeStats::STRADDLES, tid);
 							goto out;
 						}
 					}
 				} else if (reachingType == Type::TYPE_SEALED) {
 					/* remove sealed neighbor */
-					if (buffer->casSafe(nearIndex, nearSlot)) {
-						if (buffer->casType(farIndex, farSlot, GetFarType<S>())) {
-							retire(neighbor, tid);
+					if (checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+						if (checkCas(buffer->casType(farIndex, farSlot, GetFarType<S>()), OFDequeStats::CAS_FAILS_TYPE, tid)) {
+							logEvent(OFDequeStats::REMOVES, tid);
+							retire<S>(neighbor, tid);
+							noteRetire<S>();
+							if (m_maxBuffers > 0) {
+								releaseBuffer();
+							}
 							goto backoff;
 						}
 					}
@@ -454,26 +2366,36 @@ void OFDeque<T, BufferSize, Elimination>::doPush(const T &value, int tid) {
 			}
 		}
 	backoff:
+		logEvent(OFDequeStats::BACKOFFS, tid);
+		noteMiss<S>(tid);
 		if (Elimination) {
 			getElimTable<S>()->insertPush(value, tid);
-			if (getElimTable<S>()->tryEliminatePush(backoffScanCount, value, tid)) {
+			typename ElimTable<T>::ScanInfo scan;
+			uint64_t started = elimClock();
+			bool eliminated = getElimTable<S>()->tryEliminatePush(backoffScanCount, value, tid, Stats::Enabled ? &scan : NULL);
+			logElimination(scan, eliminated, started, tid);
+			if (eliminated) {
 				goto elim_out;
 			}
 			backoffScanCount <<= 1;
 		}
+		m_pContention->backoff(tid);
 	}
 elim_out:
-	m_pThreadLogs[tid].ui.m_elimPushes++;
+	logEvent(OFDequeStats::ELIM_PUSHES, tid);
 out:
-	m_pHazTracker->clearAll(tid);
+	m_pContention->end(tid);
+	m_pReclaimer->clearAll(tid);
+	return pushed;
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::popDirect(int tid) {
 	using namespace OFDequeTypes;
 
 	int backoffScanCount = m_scanCountStart;
+	m_pContention->begin(tid);
 
 	if (Elimination) {
 		getElimTable<S>()->insertPop(tid);
@@ -493,43 +2415,46 @@ T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
 		int nearIndex = oracleResult.m_edge.m_index;
 		int farIndex = nearIndex + GetFarDirection<S>();
 
-		Slot nearSlot = buffer->m_pSlots[nearIndex].load(std::memory_order_acquire);
-		Slot farSlot = buffer->m_pSlots[farIndex].load(std::memory_order_acquire);
+		Slot nearSlot = buffer->slot(nearIndex).load(std::memory_order_acquire);
+		Slot farSlot = buffer->slot(farIndex).load(std::memory_order_acquire);
 
 		Type nearType = (Type)nearSlot.m_type;
 		Type farType = (Type)farSlot.m_type;
 
 		/* check oracle edge */
-		if (nearType == GetFarType<S>() || (nearType == TYPE_SEALED && nearIndex != GetFarValueIndex<S>())) {
+		if (nearType == GetFarType<S>() || (nearType == TYPE_SEALED && nearIndex != GetFarValueIndex<S>(buffer))) {
 			goto backoff;
     }
   
-		if (farIndex != GetFarLinkIndex<S>()) {
+		if (farIndex != GetFarLinkIndex<S>(buffer)) {
 			if (farType != GetFarType<S>()) {
 				goto backoff;
 			}
 		}
 
-		if (nearIndex == GetNearLinkIndex<S>()) {
+		if (nearIndex == GetNearLinkIndex<S>(buffer)) {
 			if (nearType != GetNearType<S>()) {
 				goto backoff;
 			}
 		}
 
-		if (nearIndex != GetFarValueIndex<S>()) {
+		if (nearIndex != GetFarValueIndex<S>(buffer)) {
 			/* interior edge */
 		
 			/* check empty */
-			if (nearType == GetNearType<S>() && buffer->m_pSlots[nearIndex].load(std::memory_order_acquire).m_count == nearSlot.m_count) {
+			if (nearType == GetNearType<S>() && buffer->slot(nearIndex).load(std::memory_order_acquire).m_count == nearSlot.m_count) {
 				value = m_empty;
+				logEvent(OFDequeStats::EMPTY_POPS, tid);
 				goto out;
 			}
 
-			if (buffer->casSafe(farIndex, farSlot)) {
-				if (buffer->casType(nearIndex, nearSlot, GetFarType<S>())) {
+			if (checkCas(buffer->casSafe(farIndex, farSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+				if (checkCas(buffer->casType(nearIndex, nearSlot, GetFarType<S>()), OFDequeStats::CAS_FAILS_TYPE, tid)) {
 					/* update local hint */
-					GetLocalHint<S>(buffer).fetch_add(-GetFarDirection<S>(), std::memory_order_acq_rel);
+					moveLocalHint<S>(buffer, -GetFarDirection<S>(), nearIndex - GetFarDirection<S>(), tid);
+					moveEdgeMark<S>(buffer, nearIndex, nearIndex - GetFarDirection<S>());
 					value = nearSlot.m_value;
+					logEvent(OFDequeStats::STD_POPS, tid);
 					goto out;
 				}
 			}
@@ -537,13 +2462,13 @@ T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
 			/* edge is on border */
 			/* check if straddling edge */
 			if (farType != GetFarType<S>()) {
-				Buffer *neighbor = farSlot.m_pLink;
-				Slot reachSlot = neighbor->m_pSlots[GetNearValueIndex<S>()].load(std::memory_order_acquire);
+				Buffer *neighbor = toBuffer(farSlot.m_link);
+				Slot reachSlot = neighbor->slot(GetNearValueIndex<S>(neighbor)).load(std::memory_order_acquire);
 
 				/* check neighbor points back */
-				Slot backSlot = neighbor->m_pSlots[GetNearLinkIndex<S>()].load(std::memory_order_acquire);
+				Slot backSlot = neighbor->slot(GetNearLinkIndex<S>(neighbor)).load(std::memory_order_acquire);
 
-				if (backSlot.m_pLink != buffer) {
+				if (backSlot.m_link != toRef(buffer)) {
 					goto backoff;
         }
 
@@ -551,13 +2476,15 @@ T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
 				if (reachSlot.m_type == GetFarType<S>()) {
 					/* check empty */
 					if ((nearType == GetNearType<S>() || nearType == Type::TYPE_SEALED) &&
-							nearSlot.m_count == buffer->m_pSlots[nearIndex].load(std::memory_order_acquire).m_count) {
+							nearSlot.m_count == buffer->slot(nearIndex).load(std::memory_order_acquire).m_count) {
 						value = m_empty;
+						logEvent(OFDequeStats::EMPTY_POPS, tid);
 						goto out;
 					}
 			
-					if (buffer->casSafe(nearIndex, nearSlot)) {
-						if (neighbor->casType(GetNearValueIndex<S>(), reachSlot, Type::TYPE_SEALED)) {
+					if (checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+						if (checkCas(neighbor->casType(GetNearValueIndex<S>(neighbor), reachSlot, Type::TYPE_SEALED), OFDequeStats::CAS_FAILS_TYPE, tid)) {
+							logEvent(OFDequeStats::SEALS, tid);
 							reachSlot.m_type = Type::TYPE_SEALED;
 							reachSlot.m_count++;
 						}
@@ -568,15 +2495,21 @@ T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
 				/* remove far buffer */
 				if (reachSlot.m_type == Type::TYPE_SEALED) {
 					/* check empty */
-					if (nearSlot.m_type == GetNearType<S>() && nearSlot.m_count == buffer->m_pSlots[nearIndex].load(std::memory_order_acquire).m_count) {
+					if (nearSlot.m_type == GetNearType<S>() && nearSlot.m_count == buffer->slot(nearIndex).load(std::memory_order_acquire).m_count) {
 						value = m_empty;
+						logEvent(OFDequeStats::EMPTY_POPS, tid);
 						goto out;
 					}
 
-					if (buffer->casSafe(nearIndex, nearSlot)) {
-						if (buffer->casType(farIndex, farSlot, GetFarType<S>())) {
+					if (checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+						if (checkCas(buffer->casType(farIndex, farSlot, GetFarType<S>()), OFDequeStats::CAS_FAILS_TYPE, tid)) {
 							/* retire neighbor */
-							retire(neighbor, tid);
+							logEvent(OFDequeStats::REMOVES, tid);
+							retire<S>(neighbor, tid);
+							noteRetire<S>();
+							if (m_maxBuffers > 0) {
+								releaseBuffer();
+							}
 							farSlot.m_type = GetFarType<S>();
 							farSlot.m_count++;
 						}
@@ -588,104 +2521,363 @@ T OFDeque<T, BufferSize, Elimination>::doPop(int tid) {
 			/* check for boundary edge and boundary pop */
 			if (farSlot.m_type == GetFarType<S>()) {
 				/* check empty */
-				if (nearSlot.m_type == GetNearType<S>() && nearSlot.m_count == buffer->m_pSlots[nearIndex].load(std::memory_order_acquire).m_count) {
+				if (nearSlot.m_type == GetNearType<S>() && nearSlot.m_count == buffer->slot(nearIndex).load(std::memory_order_acquire).m_count) {
 					value = m_empty;
+					logEvent(OFDequeStats::EMPTY_POPS, tid);
 					goto out;
 				}
 
-				if (buffer->casSafe(farIndex, farSlot)) {
-					if (buffer->casType(nearIndex, nearSlot, GetFarType<S>())) {
+				if (checkCas(buffer->casSafe(farIndex, farSlot), OFDequeStats::CAS_FAILS_SAFE, tid)) {
+					if (checkCas(buffer->casType(nearIndex, nearSlot, GetFarType<S>()), OFDequeStats::CAS_FAILS_TYPE, tid)) {
 						/* update global hint */
-						getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(buffer, oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
+						getGlobalHint<S>().compare_exchange_strong(oracleResult.m_hint, GlobalHint(toRef(buffer), oracleResult.m_hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire);
 						value = nearSlot.m_value;
+						logEvent(OFDequeStats::STD_POPS, tid);
 						goto out;
 					}
 				}
 			}
 		}
 	backoff:
+		logEvent(OFDequeStats::BACKOFFS, tid);
+		noteMiss<S>(tid);
 		if (Elimination) {
 			getElimTable<S>()->insertPop(tid);
-			if (getElimTable<S>()->tryEliminatePop(backoffScanCount, value, tid)) {
+			typename ElimTable<T>::ScanInfo scan;
+			uint64_t started = elimClock();
+			bool eliminated = getElimTable<S>()->tryEliminatePop(backoffScanCount, value, tid, Stats::Enabled ? &scan : NULL);
+			logElimination(scan, eliminated, started, tid);
+			if (eliminated) {
 				goto elim_out;
 			}
 			backoffScanCount <<= 1;
 		}
+		m_pContention->backoff(tid);
 	}
 elim_out:
-	m_pThreadLogs[tid].ui.m_elimPops++;
+	logEvent(OFDequeStats::ELIM_POPS, tid);
 out:
-	m_pHazTracker->clearAll(tid);
+	if (m_batchElim && value == m_empty) {
+		/* a batch push on this side may be offering values */
+		if (getElimTable<S>()->claimBatch(&value, 1, tid) == 1) {
+			logEvent(OFDequeStats::BATCH_CLAIMS, tid);
+		}
+	}
+	m_pContention->end(tid);
+	m_pReclaimer->clearAll(tid);
+	refillAfterPop<S>(tid);
+	return value;
+}
+
+/*
+ * Read side S's end value without popping it.  The edge is found and
+ * checked as in doPop, but nothing is written: the near value is the end
+ * value if the near and far slots (and, on the border, the neighbor's
+ * reaching slot) still have the counts they were read with, so both held
+ * at once.  An empty near side, null or sealed, reads as empty the same
+ * way.  Elimination is skipped, as a peek has nothing to trade.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+T OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::doPeek(int tid) {
+	using namespace OFDequeTypes;
+
+	m_pContention->begin(tid);
+
+	T value;
+	for (;;) {
+		OracleResult oracleResult = oracle<S>(tid);
+		Buffer *buffer = oracleResult.m_edge.m_pBuffer;
+		int nearIndex = oracleResult.m_edge.m_index;
+		int farIndex = nearIndex + GetFarDirection<S>();
+
+		Slot nearSlot = buffer->slot(nearIndex).load(std::memory_order_acquire);
+		Slot farSlot = buffer->slot(farIndex).load(std::memory_order_acquire);
+
+		Type nearType = (Type)nearSlot.m_type;
+		Type farType = (Type)farSlot.m_type;
+
+		Buffer *neighbor = NULL;
+		Slot reachSlot;
+
+		/* check oracle edge */
+		if (nearType == GetFarType<S>() || (nearType == TYPE_SEALED && nearIndex != GetFarValueIndex<S>(buffer))) {
+			goto backoff;
+		}
+		if (farIndex != GetFarLinkIndex<S>(buffer) && farType != GetFarType<S>()) {
+			goto backoff;
+		}
+		if (nearIndex == GetNearLinkIndex<S>(buffer) && nearType != GetNearType<S>()) {
+			goto backoff;
+		}
+
+		/* a linked neighbor beyond the border must hold nothing on this side */
+		if (farIndex == GetFarLinkIndex<S>(buffer) && farType != GetFarType<S>()) {
+			neighbor = toBuffer(farSlot.m_link);
+			reachSlot = neighbor->slot(GetNearValueIndex<S>(neighbor)).load(std::memory_order_acquire);
+			Slot backSlot = neighbor->slot(GetNearLinkIndex<S>(neighbor)).load(std::memory_order_acquire);
+			if (backSlot.m_link != toRef(buffer) || reachSlot.m_type == TYPE_VALUE) {
+				goto backoff;
+			}
+		}
+
+		if (buffer->slot(farIndex).load(std::memory_order_acquire).m_count == farSlot.m_count &&
+				(neighbor == NULL || neighbor->slot(GetNearValueIndex<S>(neighbor)).load(std::memory_order_acquire).m_count == reachSlot.m_count) &&
+				buffer->slot(nearIndex).load(std::memory_order_acquire).m_count == nearSlot.m_count) {
+			value = (nearType == TYPE_VALUE) ? nearSlot.m_value : m_empty;
+			break;
+		}
+	backoff:
+		m_pContention->backoff(tid);
+	}
+
+	logEvent(OFDequeStats::PEEKS, tid);
+	m_pContention->end(tid);
+	m_pReclaimer->clearAll(tid);
 	return value;
 }
 
-template<typename T, int BufferSize, bool Elimination>
-template<OFDequeTypes::Side S>
-typename OFDeque<T, BufferSize, Elimination>::OracleResult OFDeque<T, BufferSize, Elimination>::oracle(int tid) {
-	using namespace OFDequeTypes;
-	
-	OracleResult result;
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::OracleResult OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::oracle(int tid) {
+	using namespace OFDequeTypes;
+	
+	OracleResult result;
+	logEvent(OFDequeStats::ORACLE_INVOKES, tid);
+
+	/* no buffer read before this call is used after it, so this is where an operation enters */
+	m_pReclaimer->enter(tid);
+
+	if (m_edgeCache) {
+		EdgeCache &cache = getEdgeCache<S>()[tid].ui;
+		GlobalHint hint = reserveHint<S>(0, tid);
+
+		/*
+		 * A buffer is retired only after both global hint counts have moved
+		 * past the count it was unlinked under, so if the count is still the
+		 * cached one once the cached buffer is reserved, it cannot have been
+		 * retired and a short search from the cached index is safe.  With
+		 * epochs the same holds for the count read after enter.
+		 */
+		if (cache.m_pBuffer != NULL && cache.m_count == hint.m_count) {
+			/* the hint's buffer is already reserved in slot 0 */
+			int hazSlot = 1;
+			if (cache.m_pBuffer != toBuffer(hint.m_buffer)) {
+				m_pReclaimer->reserve(cache.m_pBuffer, 1, tid);
+				hazSlot = 0;
+			}
+			if (hint.m_count == getGlobalHint<S>().load(std::memory_order_acquire).m_count &&
+					findEdgeFrom<S>(result.m_edge, hint, cache.m_pBuffer, cache.m_index, hazSlot, EdgeCacheProbe, tid)) {
+				logEvent(OFDequeStats::EDGE_CACHE_HITS, tid);
+				result.m_hint = hint;
+				goto out;
+			}
+		}
+	}
+
 	for (;;) {
 		GlobalHint hint = reserveHint<S>(0, tid);
 		if (findEdge<S>(result.m_edge, hint, tid)) {
 			result.m_hint = hint;
 			break;
 		}
+		logEvent(OFDequeStats::ORACLE_LOOPS, tid);
+		noteMiss<S>(tid);
 	}
 
+out:
+	if (m_edgeCache) {
+		EdgeCache &cache = getEdgeCache<S>()[tid].ui;
+		cache.m_pBuffer = result.m_edge.m_pBuffer;
+		cache.m_index = result.m_edge.m_index;
+		cache.m_count = result.m_hint.m_count;
+	}
 	return result;
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-bool OFDeque<T, BufferSize, Elimination>::findEdge(Edge &outEdge, GlobalHint hint, int tid) {
-	using namespace OFDequeTypes;
-	
-	Buffer *buffer = hint.m_pBuffer;
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::findEdge(Edge &outEdge, GlobalHint hint, int tid) {
+	Buffer *buffer = toBuffer(hint.m_buffer);
 	int index = GetLocalHint<S>(buffer).load(std::memory_order_acquire);
 	
 	/*
 	* because FAI updates to the local hints could occur in arbitrary orders,
-	* we could have a window where the index is 'invalid' (< 0 or >= BufferSize)
+	* we could have a window where the index is 'invalid' (< 0 or >= m_size);
+	* with a hint period the hint may also lag a few operations behind
 	*/
-	index = (index < 1) ? 1 : (index >= BufferSize - 1) ? BufferSize - 2 : index;
+	index = (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
 
-	int nextHazSlot = 1;
+	if (m_edgeMap) {
+		index = edgeMapStart<S>(buffer, index, tid);
+	}
+
+	return findEdgeFrom<S>(outEdge, hint, buffer, index, 1, -1, tid);
+}
+
+/*
+ * Pick where findEdge starts on @buffer, given the (clamped) local hint
+ * @index.  The hint stands if the edge map has its cache line marked;
+ * otherwise the search starts in the middle of the marked line nearest to
+ * it.  The map is only a hint like the local hint itself: marks may be
+ * stale or missing while other threads move the edge, and findEdgeFrom
+ * walks to the real edge from wherever it starts.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::edgeMapStart(Buffer *buffer, int index, int tid) {
+	std::atomic<uint64_t> *map = buffer->edgeMap(S);
+	int line = index / SlotsPerLine;
+	if (map[line / 64].load(std::memory_order_relaxed) & (1ull << (line % 64))) {
+		return index;
+	}
+
+	/* visit the words outwards from the hint's word until no closer mark can follow */
+	int bestLine = -1;
+	int bestDistance = INT_MAX;
+	int hintWord = line / 64;
+	for (int d = 0; d < buffer->m_mapWords && (d - 1) * 64 < bestDistance; ++d) {
+		int words[2] = { hintWord - d, hintWord + d };
+		for (int i = (d == 0); i < 2; ++i) {
+			int w = words[i];
+			if (w < 0 || w >= buffer->m_mapWords) {
+				continue;
+			}
+			uint64_t bits = map[w].load(std::memory_order_relaxed);
+			while (bits != 0) {
+				int l = w * 64 + __builtin_ctzll(bits);
+				int distance = l > line ? l - line : line - l;
+				if (distance < bestDistance) {
+					bestLine = l;
+					bestDistance = distance;
+				}
+				bits &= bits - 1;
+			}
+		}
+	}
+	if (bestLine < 0) {
+		return index;
+	}
+
+	logEvent(OFDequeStats::EDGE_MAP_JUMPS, tid);
+	index = bestLine * SlotsPerLine + SlotsPerLine / 2;
+	return (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
+}
+
+/*
+ * After a successful CAS moved side S's edge on @buffer from near index
+ * @from to @to, mark the cache line of @to and unmark the lines left
+ * behind.  Nothing is written while the edge stays within one line, and
+ * bits are read before they are changed, so most operations only load.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::moveEdgeMark(Buffer *buffer, int from, int to) {
+	if (!m_edgeMap) {
+		return;
+	}
+
+	int fromLine = from / SlotsPerLine;
+	int toLine = to / SlotsPerLine;
+	if (fromLine == toLine) {
+		return;
+	}
+
+	std::atomic<uint64_t> *map = buffer->edgeMap(S);
+	uint64_t bit = 1ull << (toLine % 64);
+	if (!(map[toLine / 64].load(std::memory_order_relaxed) & bit)) {
+		map[toLine / 64].fetch_or(bit, std::memory_order_relaxed);
+	}
+
+	int step = toLine > fromLine ? 1 : -1;
+	for (int line = fromLine; line != toLine; line += step) {
+		bit = 1ull << (line % 64);
+		if (map[line / 64].load(std::memory_order_relaxed) & bit) {
+			map[line / 64].fetch_and(~bit, std::memory_order_relaxed);
+		}
+	}
+}
+
+/*
+ * After a successful interior operation moved side S's edge on @buffer by
+ * @delta slots to near index @index, move the local hint along.  With the
+ * default hint period of 1 every operation adds @delta to the hint, so
+ * every push and pop writes the one line all oracles read.  With a larger
+ * period a thread only stores @index, about once in m_hintPeriod
+ * operations (drawn from a per-thread xorshift, so threads do not fall
+ * into step).  The hint then lags the edge by a few slots, which
+ * findEdgeFrom already walks off, and skipped writes never accumulate
+ * because the stored value is absolute.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::moveLocalHint(Buffer *buffer, int delta, int index, int tid) {
+	if (m_hintPeriod == 1) {
+		GetLocalHint<S>(buffer).fetch_add(delta, std::memory_order_acq_rel);
+		logEvent(OFDequeStats::HINT_WRITES, tid);
+		return;
+	}
+
+	uint32_t &random = m_pHintRandom[tid].ui;
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	if ((random & (m_hintPeriod - 1)) == 0) {
+		GetLocalHint<S>(buffer).store(index, std::memory_order_release);
+		logEvent(OFDequeStats::HINT_WRITES, tid);
+	}
+}
+
+/*
+ * Search for the edge starting at @index of @buffer, which the caller has
+ * reserved in the hazard slot other than @hazSlot.  Returns false if the
+ * global hint changed, or if @maxSteps (when not negative) search steps
+ * did not find the edge.  A step moves one slot, or over a whole run of
+ * equally typed slots (see ScanTypes).
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::findEdgeFrom(Edge &outEdge, GlobalHint hint, Buffer *buffer, int index, int hazSlot, int maxSteps, int tid) {
+	using namespace OFDequeTypes;
+
+	int nextHazSlot = hazSlot;
 	Buffer *neighbor;
 	Slot slot;
 	Type type, typeFar;
 
+	/* link and value indices depend on the size of the buffer, so they are compared rather than switched on */
 	for (;;) {
-		switch (index) {
-		case GetFarLinkIndex<S>() :
+		if (maxSteps-- == 0) {
+			return false;
+		}
+		if (index == GetFarLinkIndex<S>(buffer)) {
 			slot = buffer->loadSlot(index);
 
 			if (slot.m_type == GetFarType<S>()) {
 				index -= GetFarDirection<S>();
 			} else {
-				neighbor = slot.m_pLink;
+				neighbor = toBuffer(slot.m_link);
 				
-				m_pHazTracker->reserve(neighbor, nextHazSlot, tid);
+				m_pReclaimer->reserve(neighbor, nextHazSlot, tid);
 				nextHazSlot = !nextHazSlot;
 
 				/* if hint has changed, return false */
-				if (hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
+				if (Reclaimer::ReservesBuffers && hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 					return false;
         }
 
-				typeFar = neighbor->loadType(GetNearValueIndex<S>());
+				typeFar = neighbor->loadType(GetNearValueIndex<S>(neighbor));
 
 				if (typeFar == GetFarType<S>() || typeFar == Type::TYPE_SEALED) {
-					outEdge = Edge(buffer, GetFarValueIndex<S>());
+					outEdge = Edge(buffer, GetFarValueIndex<S>(buffer));
 					return true;
 				}
 
 				buffer = neighbor;
 				index = GetLocalHint<S>(neighbor).load(std::memory_order_acquire);
-				index = (index < 1) ? 1 : (index >= BufferSize - 1) ? BufferSize - 2 : index;
+				index = (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
 			}
-			break;
-		case GetNearLinkIndex<S>() :
+		} else if (index == GetNearLinkIndex<S>(buffer)) {
 			slot = buffer->loadSlot(index);
 
 			if (slot.m_type == GetNearType<S>()) {
@@ -699,59 +2891,61 @@ bool OFDeque<T, BufferSize, Elimination>::findEdge(Edge &outEdge, GlobalHint hin
 			} else {
 				assert(slot.m_type == TYPE_VALUE);
 
-				neighbor = slot.m_pLink;
+				neighbor = toBuffer(slot.m_link);
 
-				m_pHazTracker->reserve(neighbor, nextHazSlot, tid);
+				m_pReclaimer->reserve(neighbor, nextHazSlot, tid);
 				nextHazSlot = !nextHazSlot;
 
 				/* if hint has changed, restart from the top */
-				if (hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
+				if (Reclaimer::ReservesBuffers && hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 					return false;
         }
 
-				typeFar = neighbor->loadType(GetFarValueIndex<S>());
+				typeFar = neighbor->loadType(GetFarValueIndex<S>(neighbor));
 
 				if (typeFar != GetFarType<S>()) {
-					outEdge = Edge(neighbor, GetFarValueIndex<S>());
+					outEdge = Edge(neighbor, GetFarValueIndex<S>(neighbor));
 					return true;
 				}
 
 				buffer = neighbor;
 				index = GetLocalHint<S>(neighbor).load(std::memory_order_acquire);
-				index = (index < 1) ? 1 : (index >= BufferSize - 1) ? BufferSize - 2 : index;
+				index = (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
 			}
-			break;
-		default:
+		} else {
 			type = buffer->loadType(index);
 			switch (type) {
 			case GetFarType<S>():
-				index -= GetFarDirection<S>();
+				/* skip the run of far slots on the near side */
+				index = ScanTypes(buffer, index - GetFarDirection<S>(), -GetFarDirection<S>(), 0xf & ~(1u << GetFarType<S>()));
 				break;
 			case GetNearType<S>():
-			case Type::TYPE_VALUE:
+			case Type::TYPE_VALUE: {
 				/* found the far edge */
 				if (buffer->loadType(index + GetFarDirection<S>()) == GetFarType<S>()) {
 					outEdge = Edge(buffer, index);
 					return true;
 				}
 
-				index += GetFarDirection<S>();
+				/* skip the run of values on the far side, stopping short of the slot that ends it */
+				int next = ScanTypes(buffer, index + GetFarDirection<S>(), GetFarDirection<S>(), (1u << GetFarType<S>()) | (1u << TYPE_SEALED));
+				index = (next == index + GetFarDirection<S>()) ? next : next - GetFarDirection<S>();
 				break;
+			}
 			case Type::TYPE_SEALED:
 				/* check if the near or far value node is sealed */
-				switch (index) {
-				case GetFarValueIndex<S>() :
-					neighbor = buffer->loadSlot(GetFarLinkIndex<S>()).m_pLink;
+				if (index == GetFarValueIndex<S>(buffer)) {
+					neighbor = toBuffer(buffer->loadSlot(GetFarLinkIndex<S>(buffer)).m_link);
 					
-					m_pHazTracker->reserve(neighbor, nextHazSlot, tid);
+					m_pReclaimer->reserve(neighbor, nextHazSlot, tid);
 					nextHazSlot = !nextHazSlot;
 
 					/* if hint has changed, return false */
-					if (hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
+					if (Reclaimer::ReservesBuffers && hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 						return false;
           }
 
-					typeFar = neighbor->loadType(GetNearValueIndex<S>());
+					typeFar = neighbor->loadType(GetNearValueIndex<S>(neighbor));
 
 					if (typeFar == GetFarType<S>()) {
 						outEdge = Edge(buffer, index);
@@ -760,44 +2954,43 @@ bool OFDeque<T, BufferSize, Elimination>::findEdge(Edge &outEdge, GlobalHint hin
 
 					buffer = neighbor;
 					index = GetLocalHint<S>(neighbor).load(std::memory_order_acquire);
-					index = (index < 1) ? 1 : (index >= BufferSize - 1) ? BufferSize - 2 : index;
-					break;
-				case GetNearValueIndex<S>() :
-					neighbor = buffer->loadSlot(GetNearLinkIndex<S>()).m_pLink;
+					index = (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
+				} else if (index == GetNearValueIndex<S>(buffer)) {
+					neighbor = toBuffer(buffer->loadSlot(GetNearLinkIndex<S>(buffer)).m_link);
 					
-					m_pHazTracker->reserve(neighbor, nextHazSlot, tid);
+					m_pReclaimer->reserve(neighbor, nextHazSlot, tid);
 					nextHazSlot = !nextHazSlot;
 
 					/* if hint has changed, return false */
-					if (hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
+					if (Reclaimer::ReservesBuffers && hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 						return false;
           }
 
-					typeFar = neighbor->loadType(GetFarValueIndex<S>());
+					typeFar = neighbor->loadType(GetFarValueIndex<S>(neighbor));
 
 					if (typeFar == GetNearType<S>() || typeFar == Type::TYPE_VALUE) {
-						outEdge = Edge(neighbor, GetFarValueIndex<S>());
+						outEdge = Edge(neighbor, GetFarValueIndex<S>(neighbor));
 						return true;
 					}
 
 					buffer = neighbor;
 					index = GetLocalHint<S>(neighbor).load(std::memory_order_acquire);
-					index = (index < 1) ? 1 : (index >= BufferSize - 1) ? BufferSize - 2 : index;
-					break;
-				default:
+					index = (index < 1) ? 1 : (index >= buffer->m_size - 1) ? buffer->m_size - 2 : index;
+				} else {
 					assert(0);
 				}
 				break;
 			default:
 				assert(0);
 			}
-			break;
 		}
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
-void OFDeque<T, BufferSize, Elimination>::retire(Buffer *buffer, int tid) {
+/* @buffer has just been unlinked from side S */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::retire(Buffer *buffer, int tid) {
 	using namespace OFDequeTypes;
 
 	/* update left hint */
@@ -806,17 +2999,96 @@ void OFDeque<T, BufferSize, Elimination>::retire(Buffer *buffer, int tid) {
 	/* update right hint */
 	updateHint<SIDE_RIGHT>(tid);
 
-	/* now we can retire the buffer */
-	m_pHazTracker->retire(buffer, tid);
+	/* now we can retire the buffer, or keep it around for the next append */
+	if (m_linger > 0) {
+		linger<S>(buffer, tid);
+	} else {
+		retireNow(buffer, tid);
+	}
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::retireNow(Buffer *buffer, int tid) {
+	logEvent(OFDequeStats::RETIRES, tid);
+	m_pBufferPool->noteRetired(buffer, tid);
+	m_pReclaimer->retire(buffer, tid);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+/*
+ * Append/retire hysteresis (-d linger=K).  When the size of the deque
+ * swings across a buffer boundary, pops unlink the outer buffer and the
+ * next pushes append a new one, over and over.  The empty neighbor cannot
+ * simply stay linked: popping the value on the border slot needs the link
+ * slot next to it cleared first.  Instead the unlinked buffer lingers in a
+ * ring of its side's last K unlinked buffers, and an append on that side
+ * links it again unless some thread may still read it.  It is then still
+ * in the state it was unlinked in (every slot of the side's far type but
+ * the sealed near value slot and the near link, which the append rewrites),
+ * so linking it again skips the reclaimer, the pool and the fill of
+ * prepareBuffer.  The buffer pushed out of the ring is retired.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-typename OFDeque<T, BufferSize, Elimination>::GlobalHint OFDeque<T, BufferSize, Elimination>::reserveHint(int slot, int tid) {
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::linger(Buffer *buffer, int tid) {
+	LingerList &list = getLingerList<S>();
+	unsigned i = list.m_next.fetch_add(1, std::memory_order_relaxed) % m_linger;
+	Buffer *old = list.m_pBuffers[i].exchange(buffer, std::memory_order_acq_rel);
+	if (old != NULL) {
+		retireNow(old, tid);
+	}
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::takeLingering(int tid) {
+	using namespace OFDequeTypes;
+
+	LingerList &list = getLingerList<S>();
+	/* the most recently unlinked buffer first */
+	unsigned next = list.m_next.load(std::memory_order_relaxed);
+	for (int n = 1; n <= m_linger; ++n) {
+		std::atomic<Buffer*> &slot = list.m_pBuffers[(next - n) % m_linger];
+		if (slot.load(std::memory_order_relaxed) == NULL) {
+			continue;
+		}
+		Buffer *buffer = slot.exchange(NULL, std::memory_order_acq_rel);
+		if (buffer == NULL) {
+			continue;
+		}
+
+		/*
+		 * The hints moved off the buffer before it got here, so a thread
+		 * that reserves it from now on fails its hint check.  Only threads
+		 * that reserved it before can still read it.
+		 */
+		if (buffer->m_sizeClass != getSizePolicy<S>().m_sizeClass.load(std::memory_order_relaxed) || m_pReclaimer->isReserved(buffer)) {
+			retireNow(buffer, tid);
+			return NULL;
+		}
+
+		Slot s;
+		s.m_type = GetFarType<S>();
+		buffer->slot(GetNearValueIndex<S>(buffer)).store(s, std::memory_order_relaxed);
+		buffer->m_leftLocalHint.ui.store(GetNearValueIndex<S>(buffer), std::memory_order_relaxed);
+		buffer->m_rightLocalHint.ui.store(GetNearValueIndex<S>(buffer), std::memory_order_relaxed);
+		buffer->resetEdgeMaps();
+		logEvent(OFDequeStats::RELINKS, tid);
+		return buffer;
+	}
+	return NULL;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GlobalHint OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::reserveHint(int slot, int tid) {
+	if (!Reclaimer::ReservesBuffers) {
+		return getGlobalHint<S>().load(std::memory_order_acquire);
+	}
+
 	for (;;) {
 		GlobalHint hint = getGlobalHint<S>().load(std::memory_order_acquire);
 
-		m_pHazTracker->reserve(hint.m_pBuffer, slot, tid);
+		m_pReclaimer->reserve(toBuffer(hint.m_buffer), slot, tid);
 
 		if (hint.m_count == getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 			return hint;
@@ -824,15 +3096,15 @@ typename OFDeque<T, BufferSize, Elimination>::GlobalHint OFDeque<T, BufferSize,
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-void OFDeque<T, BufferSize, Elimination>::updateHint(int tid) {
-	uint32_t threshold = getGlobalHint<S>().load(std::memory_order_acquire).m_count;
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::updateHint(int tid) {
+	SlotWord threshold = getGlobalHint<S>().load(std::memory_order_acquire).m_count;
 
 	for (;;) {
 		GlobalHint hint = getGlobalHint<S>().load(std::memory_order_acquire);
 
-		Buffer *buffer = hint.m_pBuffer;
+		Buffer *buffer = toBuffer(hint.m_buffer);
 
 		if (buffer->isSealed() == -1) {
 			/* if the buffer is not sealed and the hint has changed, someone else has done our work */
@@ -848,54 +3120,69 @@ void OFDeque<T, BufferSize, Elimination>::updateHint(int tid) {
 			assert(buffer != NULL);
 		}
 
-		if (getGlobalHint<S>().compare_exchange_strong(hint, GlobalHint(buffer, hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire)) {
+		if (getGlobalHint<S>().compare_exchange_strong(hint, GlobalHint(toRef(buffer), hint.m_count + 1), std::memory_order_acq_rel, std::memory_order_acquire)) {
 			break;
 		}
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-bool OFDeque<T, BufferSize, Elimination>::findActiveBuffer(Buffer **outBuffer, GlobalHint hint, int tid) {
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::findActiveBuffer(Buffer **outBuffer, GlobalHint hint, int tid) {
 	using namespace OFDequeTypes;
 
 	int nextHazSlot = 1;
 
-	Buffer *buffer = hint.m_pBuffer;
+	Buffer *buffer = toBuffer(hint.m_buffer);
 
 	for (;;) {
 		int sealedIndex = buffer->isSealed();
 	
 		Slot slot;
-		switch (sealedIndex) {
-		case -1:
+		if (sealedIndex == -1) {
 			*outBuffer = buffer;
 			return true;
-		case GetFarValueIndex<S>():
-			slot = buffer->loadSlot(GetFarLinkIndex<S>());			
-			break;
-		case GetNearValueIndex<S>():
-			slot = buffer->loadSlot(GetNearLinkIndex<S>());
-			break;
-		default:
+		} else if (sealedIndex == GetFarValueIndex<S>(buffer)) {
+			slot = buffer->loadSlot(GetFarLinkIndex<S>(buffer));
+		} else if (sealedIndex == GetNearValueIndex<S>(buffer)) {
+			slot = buffer->loadSlot(GetNearLinkIndex<S>(buffer));
+		} else {
 			assert(0);
 		}
 
-		m_pHazTracker->reserve(slot.m_pLink, nextHazSlot, tid);
+		m_pReclaimer->reserve(toBuffer(slot.m_link), nextHazSlot, tid);
 		nextHazSlot = !nextHazSlot;		
 
 		/* if hint has changed, return false */
-		if (hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
+		if (Reclaimer::ReservesBuffers && hint.m_count != getGlobalHint<S>().load(std::memory_order_acquire).m_count) {
 			return false;
     }
 
-		buffer = slot.m_pLink;
+		buffer = toBuffer(slot.m_link);
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination> 
-void OFDeque<T, BufferSize, Elimination>::Buffer::fill(int split) {
-	assert(split >= 0 && split < BufferSize);
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::toBuffer(BufferRef ref) {
+#ifdef OFDEQUE_INDEXED_LINKS
+	return m_pBufferPool->fromIndex(ref);
+#else
+	return ref;
+#endif
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::BufferRef OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::toRef(Buffer *buffer) {
+#ifdef OFDEQUE_INDEXED_LINKS
+	return m_pBufferPool->indexOf(buffer);
+#else
+	return buffer;
+#endif
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> 
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer::fill(int split) {
+	assert(split >= 0 && split < m_size);
 
 	m_leftLocalHint.ui.store(split, std::memory_order_relaxed);
 	m_rightLocalHint.ui.store(split - 1, std::memory_order_relaxed);
@@ -903,31 +3190,52 @@ void OFDeque<T, BufferSize, Elimination>::Buffer::fill(int split) {
 	for (int i = 0; i < split; ++i) {
 		Slot s;
 		s.m_type = OFDequeTypes::TYPE_LEFT;
-		m_pSlots[i].store(s, std::memory_order_relaxed);
+		slot(i).store(s, std::memory_order_relaxed);
 	}
 
-	for (int i = split; i < BufferSize; ++i) {
+	for (int i = split; i < m_size; ++i) {
 		Slot s;
 		s.m_type = OFDequeTypes::TYPE_RIGHT;
-		m_pSlots[i].store(s, std::memory_order_relaxed);
+		slot(i).store(s, std::memory_order_relaxed);
+	}
+
+	resetEdgeMaps();
+}
+
+/* clear both edge maps and mark the lines the local hints point to */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer::resetEdgeMaps() {
+	if (m_mapWords == 0) {
+		return;
+	}
+
+	OFDequeTypes::Side sides[2] = { OFDequeTypes::SIDE_LEFT, OFDequeTypes::SIDE_RIGHT };
+	int hints[2] = { m_leftLocalHint.ui.load(std::memory_order_relaxed), m_rightLocalHint.ui.load(std::memory_order_relaxed) };
+	for (int i = 0; i < 2; ++i) {
+		std::atomic<uint64_t> *map = edgeMap(sides[i]);
+		for (int w = 0; w < m_mapWords; ++w) {
+			map[w].store(0, std::memory_order_relaxed);
+		}
+		int line = (hints[i] < 0 ? 0 : hints[i]) / SlotsPerLine;
+		map[line / 64].store(1ull << (line % 64), std::memory_order_relaxed);
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
-int OFDeque<T, BufferSize, Elimination>::Buffer::isSealed() {
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer::isSealed() {
 	using namespace OFDequeTypes;
 
 	Slot n0, n1;
 
 	for (;;) {
-		n0 = m_pSlots[1].load(std::memory_order_acquire);
-		n1 = m_pSlots[BufferSize - 2].load(std::memory_order_acquire);
+		n0 = slot(1).load(std::memory_order_acquire);
+		n1 = slot(m_size - 2).load(std::memory_order_acquire);
 
-		if (n0.m_count == m_pSlots[1].load(std::memory_order_acquire).m_count) {
+		if (n0.m_count == slot(1).load(std::memory_order_acquire).m_count) {
 			if (n0.m_type == TYPE_SEALED) {
 				return 1;
 			} else if (n1.m_type == TYPE_SEALED) {
-				return BufferSize - 2;
+				return m_size - 2;
 			} else {
 				return -1;
 			}
@@ -935,71 +3243,550 @@ int OFDeque<T, BufferSize, Elimination>::Buffer::isSealed() {
 	}
 }
 
-template<typename T, int BufferSize, bool Elimination>
+/*
+ * Starting at @index and moving by @step (1 or -1), return the first value
+ * slot whose type is in the bit set @stopTypes, or the first index past the
+ * value slots (a link index) if there is none.
+ *
+ * The AVX2 path reads 32 bytes of slots with one plain vector load, which
+ * is not atomic as a whole but is per 8 byte word, and every slot type is
+ * in a single word (the top two bits of the count word).  A slot may change
+ * type while it is read; the search only steers findEdge, and the edge it
+ * returns is checked by the caller's CAS like any other.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::ScanTypes(Buffer *buffer, int index, int step, unsigned stopTypes) {
+	int low = 1;
+	int high = buffer->m_size - 2;
+
+#ifdef OFDEQUE_AVX2_EDGE_SEARCH
+	static_assert(sizeof(Atomic<Slot>) == sizeof(Slot) && (sizeof(Slot) == 8 || sizeof(Slot) == 16), "unexpected slot layout");
+	const int slotsPerVector = 32 / sizeof(Slot);
+	/* lanes holding a count/type word: all of them with 8 byte slots, the upper half of each 16 byte slot */
+	const unsigned typeLanes = (sizeof(Slot) == 8) ? 0xf : 0xa;
+
+	__m256i stop[4];
+	int stopCount = 0;
+	for (int type = 0; type < 4; ++type) {
+		if (stopTypes & (1u << type)) {
+			stop[stopCount++] = _mm256_set1_epi64x(type);
+		}
+	}
+
+#ifdef OFDEQUE_STRIPED_SLOTS
+	/*
+	 * A vector no longer holds consecutive slots, but a whole tile is
+	 * SlotTile slots in a row in memory: step slot by slot up to a tile
+	 * boundary, skip whole tiles that hold no stop type, and finish the
+	 * tile that does slot by slot.
+	 */
+	while (index >= low && index <= high) {
+		int first = (step > 0) ? index : index - (SlotTile - 1);
+		if ((first & (SlotTile - 1)) == 0 && first >= low && first + SlotTile - 1 <= high) {
+			bool found = false;
+			for (int v = 0; v < SlotTile && !found; v += slotsPerVector) {
+				__m256i types = _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)&buffer->m_pSlots[first + v]), 62);
+				for (int i = 0; i < stopCount; ++i) {
+					if (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(types, stop[i]))) & typeLanes) {
+						found = true;
+					}
+				}
+			}
+			if (!found) {
+				index += step * SlotTile;
+				continue;
+			}
+			for (int i = 0; i < SlotTile; ++i, index += step) {
+				if (stopTypes & (1u << buffer->loadType(index))) {
+					return index;
+				}
+			}
+			continue;
+		}
+		if (stopTypes & (1u << buffer->loadType(index))) {
+			return index;
+		}
+		index += step;
+	}
+	return index;
+#else
+	for (;;) {
+		int first = (step > 0) ? index : index - (slotsPerVector - 1);
+		if (first < low || first + slotsPerVector - 1 > high) {
+			break;
+		}
+
+		__m256i types = _mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)&buffer->m_pSlots[first]), 62);
+		__m256i hits = _mm256_setzero_si256();
+		for (int i = 0; i < stopCount; ++i) {
+			hits = _mm256_or_si256(hits, _mm256_cmpeq_epi64(types, stop[i]));
+		}
+
+		unsigned lanes = _mm256_movemask_pd(_mm256_castsi256_pd(hits)) & typeLanes;
+		if (lanes != 0) {
+			int lane = (step > 0) ? __builtin_ctz(lanes) : 31 - __builtin_clz(lanes);
+			return first + lane * (int)sizeof(uint64_t) / (int)sizeof(Slot);
+		}
+		index += step * slotsPerVector;
+	}
+#endif
+#endif
+
+	for (; index >= low && index <= high; index += step) {
+		if (stopTypes & (1u << buffer->loadType(index))) {
+			break;
+		}
+	}
+	return index;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-constexpr int OFDeque<T, BufferSize, Elimination>::GetFarLinkIndex() { 
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetFarLinkIndex(); 
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarLinkIndex(Buffer *buffer) { 
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarLinkIndex(buffer->m_size); 
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-constexpr int OFDeque<T, BufferSize, Elimination>::GetNearLinkIndex() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetNearLinkIndex();
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearLinkIndex(Buffer *buffer) {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearLinkIndex(buffer->m_size);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-constexpr int OFDeque<T, BufferSize, Elimination>::GetFarValueIndex() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetFarValueIndex();
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarValueIndex(Buffer *buffer) {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarValueIndex(buffer->m_size);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-constexpr int OFDeque<T, BufferSize, Elimination>::GetNearValueIndex() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetNearValueIndex();
+int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearValueIndex(Buffer *buffer) {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearValueIndex(buffer->m_size);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-std::atomic<int> &OFDeque<T, BufferSize, Elimination>::GetLocalHint(Buffer *buf) {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetLocalHint(buf);
+std::atomic<int> &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetLocalHint(Buffer *buf) {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetLocalHint(buf);
 }
 
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-constexpr int OFDeque<T, BufferSize, Elimination>::GetFarDirection() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetFarDirection();
+constexpr int OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarDirection() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarDirection();
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-constexpr OFDequeTypes::Type OFDeque<T, BufferSize, Elimination>::GetFarType() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetFarType();
+constexpr OFDequeTypes::Type OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarType() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetFarType();
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-constexpr OFDequeTypes::Type OFDeque<T, BufferSize, Elimination>::GetNearType() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetNearType();
+constexpr OFDequeTypes::Type OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearType() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetNearType();
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-std::atomic<typename OFDeque<T, BufferSize, Elimination>::GlobalHint> &OFDeque<T, BufferSize, Elimination>::getGlobalHint() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetGlobalHint(this);
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::template Atomic<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::GlobalHint> &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getGlobalHint() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetGlobalHint(this);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S> 
-padded<typename OFDeque<T, BufferSize, Elimination>::Buffer*> *OFDeque<T, BufferSize, Elimination>::getBufferCache() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetBufferCache(this);
+padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer*> *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getBufferCache() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetBufferCache(this);
 }
 
-template<typename T, int BufferSize, bool Elimination>
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
 template<OFDequeTypes::Side S>
-ElimTable<T> *OFDeque<T, BufferSize, Elimination>::getElimTable() {
-	return OFDequeUtils<S, T, BufferSize, Elimination>::GetElimTable(this);
+padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::EdgeCache> *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getEdgeCache() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetEdgeCache(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+ElimTable<T> *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getElimTable() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetElimTable(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::SizePolicy &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getSizePolicy() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetSizePolicy(this);
+}
+
+/*
+ * Adaptive sizing.  Every AdaptWindow appends on a side, look at how many
+ * buffers that side retired meanwhile.  Few retires mean the side is
+ * growing, so append larger buffers and append less often.  Nearly as many
+ * retires as appends mean buffers are added and removed again at the
+ * border, so append smaller buffers that are cheap to fill and hold less
+ * memory.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::noteAppend() {
+	if (!m_sizes.isAdaptive()) {
+		return;
+	}
+
+	SizePolicy &policy = getSizePolicy<S>();
+	if ((policy.m_appends.fetch_add(1, std::memory_order_relaxed) + 1) % AdaptWindow != 0) {
+		return;
+	}
+
+	int retires = policy.m_retires.exchange(0, std::memory_order_relaxed);
+	int sizeClass = policy.m_sizeClass.load(std::memory_order_relaxed);
+	if (retires * 4 <= AdaptWindow) {
+		if (sizeClass + 1 < m_pBufferPool->getClassCount()) {
+			++sizeClass;
+		}
+	} else if (retires * 4 >= AdaptWindow * 3) {
+		if (sizeClass > 0) {
+			--sizeClass;
+		}
+	}
+	policy.m_sizeClass.store(sizeClass, std::memory_order_relaxed);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::noteRetire() {
+	if (m_sizes.isAdaptive()) {
+		getSizePolicy<S>().m_retires.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::BufferReserve &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getBufferReserve() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetBufferReserve(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::LingerList &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getLingerList() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetLingerList(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Combiner &OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getCombiner() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetCombiner(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::CombineRequest> *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getCombineRequests() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetCombineRequests(this);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+padded<typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::ContentionWindow> *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::getContentionWindows() {
+	return OFDequeUtils<S, T, Elimination, Stats, Reclaimer, ContentionManager>::GetContentionWindows(this);
+}
+
+/* allocate a buffer and fill it with far type slots, ready to be appended on side S */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::prepareBuffer(int sizeClass, int tid) {
+	Buffer *buffer = m_pBufferPool->alloc(sizeClass, tid);
+	buffer->m_leftLocalHint.ui.store(GetNearValueIndex<S>(buffer), std::memory_order_relaxed);
+	buffer->m_rightLocalHint.ui.store(GetNearValueIndex<S>(buffer), std::memory_order_relaxed);
+
+	for (int i = 0; i < buffer->m_size; ++i) {
+		Slot s;
+		s.m_type = GetFarType<S>();
+		buffer->slot(i).store(s, std::memory_order_relaxed);
+	}
+	buffer->resetEdgeMaps();
+	return buffer;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+typename OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::Buffer *OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::takeReserved(int tid) {
+	BufferReserve &reserve = getBufferReserve<S>();
+	if (reserve.m_count.load(std::memory_order_relaxed) <= 0) {
+		return NULL;
+	}
+
+	for (int i = 0; i < m_reserve.m_depth; ++i) {
+		std::atomic<Buffer*> &slot = reserve.m_pBuffers[(tid + i) % m_reserve.m_depth];
+		if (slot.load(std::memory_order_relaxed) != NULL) {
+			Buffer *buffer = slot.exchange(NULL, std::memory_order_acquire);
+			if (buffer != NULL) {
+				reserve.m_count.fetch_sub(1, std::memory_order_relaxed);
+				return buffer;
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Add one buffer to the reserve of side S unless it is full.  A refiller
+ * claims its place in m_count before preparing the buffer, so it never
+ * prepares a buffer there is no room for: while the claim is held fewer
+ * than m_depth slots are occupied, and the scan is bound to find a free one.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::refillReserve(int tid) {
+	BufferReserve &reserve = getBufferReserve<S>();
+	if (reserve.m_count.load(std::memory_order_relaxed) >= m_reserve.m_depth) {
+		return false;
+	}
+	if (reserve.m_count.fetch_add(1, std::memory_order_relaxed) >= m_reserve.m_depth) {
+		reserve.m_count.fetch_sub(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Buffer *buffer = prepareBuffer<S>(getSizePolicy<S>().m_sizeClass.load(std::memory_order_relaxed), tid);
+	for (int i = tid;; ++i) {
+		std::atomic<Buffer*> &slot = reserve.m_pBuffers[i % m_reserve.m_depth];
+		Buffer *expected = NULL;
+		if (slot.load(std::memory_order_relaxed) == NULL &&
+				slot.compare_exchange_strong(expected, buffer, std::memory_order_release, std::memory_order_relaxed)) {
+			return true;
+		}
+	}
+}
+
+/* pops refill at most one buffer, own side first, unless a helper does it */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+template<OFDequeTypes::Side S>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::refillAfterPop(int tid) {
+	if (m_reserve.m_depth == 0 || m_reserve.m_helper) {
+		return;
+	}
+	if (!refillReserve<S>(tid)) {
+		refillReserve<(OFDequeTypes::Side)(1 - S)>(tid);
+	}
+}
+
+/* helper thread body; allocates as thread m_threadCount */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::runReserveHelper() {
+	while (!m_stopReserveHelper.load(std::memory_order_acquire)) {
+		bool left = refillReserve<OFDequeTypes::SIDE_LEFT>(m_threadCount);
+		bool right = refillReserve<OFDequeTypes::SIDE_RIGHT>(m_threadCount);
+		if (!left && !right) {
+			usleep(ReserveHelperSleep);
+		}
+	}
+}
+
+/*
+ * Bounded mode (-d maxbuffers=N).  The limit is on buffers linked into the
+ * chain, so it only costs anything on appends and removes: a push claims a
+ * buffer before it tries to append and hands the claim back if the append
+ * fails, a pop releases one for every buffer it unlinks.  Interior pushes
+ * never look at the count.  The count starts at 1 for the initial buffer.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::claimBuffer() {
+	int count = m_bufferCount.ui.load(std::memory_order_relaxed);
+	do {
+		if (count >= m_maxBuffers) {
+			return false;
+		}
+	} while (!m_bufferCount.ui.compare_exchange_weak(count, count + 1, std::memory_order_relaxed, std::memory_order_relaxed));
+	return true;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::releaseBuffer() {
+	m_bufferCount.ui.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::addThreadLogs(Recorder *r) {
+	m_pContention->addThreadLogs(r);
+	if (!Stats::Enabled) {
+		return;
+	}
+	for (int i = 0; i < OFDequeStats::COUNTER_COUNT; ++i) {
+		r->addThreadField(std::string(OFDequeStats::GetName((OFDequeStats::Counter)i)) + "_total", &Recorder::sumInts);
+	}
+	r->addThreadField("retiredPeakKB_total", &Recorder::sumInts);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::reportThreadLogs(Recorder *r, int tid) {
+	m_pContention->reportThreadLogs(r, tid);
+	if (!Stats::Enabled) {
+		return;
+	}
+	for (int i = 0; i < OFDequeStats::COUNTER_COUNT; ++i) {
+		OFDequeStats::Counter counter = (OFDequeStats::Counter)i;
+		r->reportThreadInfo(std::string(OFDequeStats::GetName(counter)) + "_total", Stats::Get(m_pThreadLogs[tid].ui, counter), tid);
+	}
+	/* sum of the per thread peaks, an upper bound on the peak of retired buffer memory */
+	r->reportThreadInfo("retiredPeakKB_total", (int)(m_pBufferPool->getRetiredPeak(tid) / 1024), tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::logEvent(OFDequeStats::Counter counter, int tid, int n) {
+	Stats::Add(m_pThreadLogs[tid].ui, counter, n);
+}
+
+/* pass a CAS result through, counting it under @counter if it failed */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::checkCas(bool success, OFDequeStats::Counter counter, int tid) {
+	logEvent(OFDequeStats::SLOT_CASES, tid);
+	if (!success) {
+		logEvent(counter, tid);
+	}
+	return success;
+}
+
+/* start of an elimination try in ns, only read when statistics are kept */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+uint64_t OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::elimClock() {
+	if (!Stats::Enabled) {
+		return 0;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/*
+ * Count an elimination try: the table lines it read, in total and per
+ * distance class, and for a try that found its partner the partner's class
+ * and the time the try took.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::logElimination(const typename ElimTable<T>::ScanInfo &scan, bool eliminated, uint64_t started, int tid) {
+	using namespace OFDequeStats;
+	if (!Stats::Enabled) {
+		return;
+	}
+	logEvent(ELIM_TRIES, tid);
+	for (int d = 0; d < ElimTable<T>::DISTANCE_COUNT; ++d) {
+		logEvent(ELIM_LINES, tid, scan.scanned[d]);
+		logEvent((Counter)(ELIM_LINES_NEAR + d), tid, scan.scanned[d]);
+	}
+	if (eliminated && scan.partner >= 0) {
+		logEvent((Counter)(ELIM_HITS_NEAR + scan.partner), tid);
+		logEvent((Counter)(ELIM_NS_NEAR + scan.partner), tid, (int)(elimClock() - started));
+	}
+}
+
+/*
+ * Interior push of @value: mark the near slot safe, then write the value
+ * into the far slot.  With -d paircas=1 a near and far slot that share an
+ * aligned 16 byte word (about every other push) are updated together by
+ * one cmpxchg16b, which also closes the window between the two CASes;
+ * other pairs, and every pair on other builds, take the two CASes.
+ */
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+bool OFDeque<T, Elimination, Stats, Reclaimer, ContentionManager>::casPush(Buffer *buffer, int nearIndex, Slot nearSlot, int farIndex, Slot farSlot, const T &value, int tid) {
+#if OFDEQUE_PAIRED_CAS
+	if (m_pairCas && buffer->isPair(nearIndex, farIndex)) {
+		logEvent(OFDequeStats::PAIR_CASES, tid);
+		/* count a failure like the two CASes would: against the near slot if it moved, else the far one */
+		bool nearChanged = false;
+		bool success = buffer->casSafeValue(nearIndex, nearSlot, farIndex, farSlot, value, &nearChanged);
+		return checkCas(success, nearChanged ? OFDequeStats::CAS_FAILS_SAFE : OFDequeStats::CAS_FAILS_VALUE, tid);
+	}
+#endif
+	return checkCas(buffer->casSafe(nearIndex, nearSlot), OFDequeStats::CAS_FAILS_SAFE, tid) && checkCas(buffer->casValue(farIndex, farSlot, value), OFDequeStats::CAS_FAILS_VALUE, tid);
+}
+
+/* ----------------------- */
+/* --- Boxed payloads  --- */
+/* ----------------------- */
+
+/*
+ * OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager> holds values of any size or
+ * type, including move-only ones.  Push move-constructs the value into the
+ * pushing thread's ValueArena and the deque itself only carries the 32-bit
+ * arena handle; pop moves the value out and recycles the cell.  Nothing is
+ * malloc'ed per element.
+ */
+template<typename T> struct OFBoxed { };
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager> class OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager> {
+public:
+	/* --- Constructors & Destructor --- */
+	OFDeque(int threadCount, bool glibc, OFDequeOptions options = OFDequeOptions::Defaults());
+	~OFDeque();
+	/* --- Instance Methods (Interface) --- */
+	void left_push(T &&value, int tid);
+	void left_push(const T &value, int tid);
+	void right_push(T &&value, int tid);
+	void right_push(const T &value, int tid);
+	// return false if the deque is empty, otherwise move the value into outValue
+	bool left_pop(T &outValue, int tid);
+	bool right_pop(T &outValue, int tid);
+private:
+	typedef typename ValueArena<T>::Handle Handle;
+
+	/* --- Instance Fields --- */
+	OFDeque<Handle, Elimination, Stats, Reclaimer, ContentionManager> m_handles;
+	ValueArena<T> m_arena;
+};
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::OFDeque(int threadCount, bool glibc, OFDequeOptions options) :
+	m_handles(EMPTY, threadCount, glibc, options),
+	m_arena(threadCount) {
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::~OFDeque() {
+	// run destructors of anything still queued
+	Handle handle;
+	while ((handle = m_handles.left_pop(0)) != EMPTY) {
+		m_arena.destroy(handle, 0);
+	}
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::left_push(T &&value, int tid) {
+	m_handles.left_push(m_arena.emplace(std::move(value), tid), tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::left_push(const T &value, int tid) {
+	m_handles.left_push(m_arena.emplace(value, tid), tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::right_push(T &&value, int tid) {
+	m_handles.right_push(m_arena.emplace(std::move(value), tid), tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+void OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::right_push(const T &value, int tid) {
+	m_handles.right_push(m_arena.emplace(value, tid), tid);
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+bool OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::left_pop(T &outValue, int tid) {
+	Handle handle = m_handles.left_pop(tid);
+	if (handle == EMPTY) {
+		return false;
+	}
+	m_arena.take(handle, outValue, tid);
+	return true;
+}
+
+template<typename T, bool Elimination, typename Stats, typename Reclaimer, typename ContentionManager>
+bool OFDeque<OFBoxed<T>, Elimination, Stats, Reclaimer, ContentionManager>::right_pop(T &outValue, int tid) {
+	Handle handle = m_handles.right_pop(tid);
+	if (handle == EMPTY) {
+		return false;
+	}
+	m_arena.take(handle, outValue, tid);
+	return true;
 }
 
 #endif
@@ -0,0 +1,122 @@
+#ifndef PAYLOADDEQUE_HPP
+#define PAYLOADDEQUE_HPP
+
+#include <cassert>
+#include <cinttypes>
+
+#include "RDeque.hpp"
+#include "Rideable.hpp"
+#include "OFDeque.hpp"
+#include "FCDeque.hpp"
+#if UINTPTR_MAX <= 0xffffffffu
+#include "MMDeque.hpp"
+#endif
+
+/*
+ * Benchmark payload of Size bytes.  Every word carries the same value, so a
+ * torn or partially moved payload is caught when it is popped.
+ */
+template<int Size> struct Payload {
+	static_assert(Size % sizeof(int32_t) == 0 && Size > 0, "payload size must be a multiple of 4");
+
+	Payload() {
+		for (int i = 0; i < Words; i++) {
+			m_words[i] = EMPTY;
+		}
+	}
+	explicit Payload(int32_t value) {
+		for (int i = 0; i < Words; i++) {
+			m_words[i] = value;
+		}
+	}
+
+	inline bool operator==(const Payload &p) const {
+		for (int i = 0; i < Words; i++) {
+			if (m_words[i] != p.m_words[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline int32_t get() const {
+		for (int i = 1; i < Words; i++) {
+			assert(m_words[i] == m_words[0]);
+		}
+		return m_words[0];
+	}
+
+	static const int Words = Size / sizeof(int32_t);
+	int32_t m_words[Words];
+};
+
+/*
+ * Wraps a deque of Payload<Size> in the int32_t RDeque interface so the
+ * ordinary tests can drive it: pushes build a payload around the value and
+ * pops unpack it again.
+ */
+template<typename D, int Size> class PayloadDeque : public RDeque {
+public:
+	PayloadDeque(D *deque) : m_pDeque(deque) { }
+	~PayloadDeque() { delete m_pDeque; }
+
+	void left_push(int32_t val, int tid) { m_pDeque->left_push(Payload<Size>(val), tid); }
+	void right_push(int32_t val, int tid) { m_pDeque->right_push(Payload<Size>(val), tid); }
+	int32_t left_pop(int tid) {
+		Payload<Size> p;
+		return PopLeft(m_pDeque, p, tid) ? p.get() : EMPTY;
+	}
+	int32_t right_pop(int tid) {
+		Payload<Size> p;
+		return PopRight(m_pDeque, p, tid) ? p.get() : EMPTY;
+	}
+
+private:
+	// deques that return their empty value
+	template<typename E> static bool PopLeft(E *deque, Payload<Size> &p, int tid) {
+		p = deque->left_pop(tid);
+		return !(p == Payload<Size>());
+	}
+	template<typename E> static bool PopRight(E *deque, Payload<Size> &p, int tid) {
+		p = deque->right_pop(tid);
+		return !(p == Payload<Size>());
+	}
+	// deques that report emptiness separately
+	template<bool E> static bool PopLeft(OFDeque<OFBoxed<Payload<Size> >, E> *deque, Payload<Size> &p, int tid) {
+		return deque->left_pop(p, tid);
+	}
+	template<bool E> static bool PopRight(OFDeque<OFBoxed<Payload<Size> >, E> *deque, Payload<Size> &p, int tid) {
+		return deque->right_pop(p, tid);
+	}
+
+	D *m_pDeque;
+};
+
+template<int Size, bool Elimination> class OFDequePayloadFactory : public RContainerFactory {
+public:
+	OFDequePayloadFactory(int defaultBufferSize = 512) : m_defaultBufferSize(defaultBufferSize) { }
+	RContainer *build(GlobalTestConfig *gtc) {
+		typedef OFDeque<OFBoxed<Payload<Size> >, Elimination> D;
+		return new PayloadDeque<D, Size>(new D(gtc->task_num, gtc->environment["glibc"] == "1", OFDequeOptions::FromEnvironment(gtc, m_defaultBufferSize)));
+	}
+private:
+	int m_defaultBufferSize;
+};
+
+template<int Size> class FCDequePayloadFactory : public RContainerFactory {
+	RContainer *build(GlobalTestConfig *gtc) {
+		typedef FCDeque<Payload<Size> > D;
+		return new PayloadDeque<D, Size>(new D(gtc->task_num, Payload<Size>()));
+	}
+};
+
+#if UINTPTR_MAX <= 0xffffffffu
+template<int Size> class MMDequePayloadFactory : public RContainerFactory {
+	RContainer *build(GlobalTestConfig *gtc) {
+		typedef MMDeque<Payload<Size> > D;
+		return new PayloadDeque<D, Size>(new D(gtc->task_num, gtc->environment["glibc"] == "1", Payload<Size>()));
+	}
+};
+#endif
+
+#endif
@@ -3,8 +3,16 @@
 #define RDEQUE_HPP
 
 #include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
 #include "RContainer.hpp"
 
+// returned by peek_left and peek_right of deques that cannot peek
+#define PEEK_UNSUPPORTED INT32_MIN
+
 class RDeque : public virtual RContainer {
 public:
 	virtual ~RDeque() { };
@@ -25,9 +33,115 @@ public:
 	// tid: Thread id, unique across all threads
 	virtual void right_push(int32_t val,int tid)=0;
 
+	// left push vals[0..n-1] in that order, so vals[n-1] ends up leftmost.
+	// tid: Thread id, unique across all threads
+	virtual void left_push_n(const int32_t *vals,int n,int tid){
+		for(int i=0;i<n;i++){left_push(vals[i],tid);}
+	}
+
+	// right push vals[0..n-1] in that order, so vals[n-1] ends up rightmost.
+	// tid: Thread id, unique across all threads
+	virtual void right_push_n(const int32_t *vals,int n,int tid){
+		for(int i=0;i<n;i++){right_push(vals[i],tid);}
+	}
+
+	// left pop up to n values into out. Returns the number popped, which is
+	// less than n only if the deque was found empty.
+	// tid: Thread id, unique across all threads
+	virtual int left_pop_n(int32_t *out,int n,int tid){
+		int i;
+		for(i=0;i<n;i++){
+			out[i]=left_pop(tid);
+			if(out[i]==EMPTY){break;}
+		}
+		return i;
+	}
+
+	// right pop up to n values into out. Returns the number popped, which is
+	// less than n only if the deque was found empty.
+	// tid: Thread id, unique across all threads
+	virtual int right_pop_n(int32_t *out,int n,int tid){
+		int i;
+		for(i=0;i<n;i++){
+			out[i]=right_pop(tid);
+			if(out[i]==EMPTY){break;}
+		}
+		return i;
+	}
+
+	// leftmost value without removing it. Returns EMPTY if empty. The value
+	// may be popped by another thread before the caller acts on it. Returns
+	// PEEK_UNSUPPORTED for deques that cannot peek (the default).
+	// tid: Thread id, unique across all threads
+	virtual int32_t peek_left(int tid){return PEEK_UNSUPPORTED;}
+
+	// rightmost value without removing it, like peek_left.
+	// tid: Thread id, unique across all threads
+	virtual int32_t peek_right(int tid){return PEEK_UNSUPPORTED;}
+
+	// number of values in the deque, possibly stale under concurrent
+	// operations. Returns -1 for deques that do not keep track (the default).
+	// tid: Thread id, unique across all threads
+	virtual long size_approx(int tid){return -1;}
+
+	// values the deque takes for sure before left_push and right_push wait
+	// for pops to make room. Returns LONG_MAX for deques without a bound
+	// (the default).
+	virtual long min_capacity(){return LONG_MAX;}
+
+	// left push that gives up instead of waiting for other threads. Returns
+	// false, having pushed nothing, if the deque is busy or cannot tell
+	// (the default). EliminatingDeque tries it before eliminating.
+	// tid: Thread id, unique across all threads
+	virtual bool try_left_push_uncontended(int32_t val,int tid){return false;}
+
+	// right push that gives up instead of waiting, like
+	// try_left_push_uncontended.
+	// tid: Thread id, unique across all threads
+	virtual bool try_right_push_uncontended(int32_t val,int tid){return false;}
+
+	// left pop that gives up instead of waiting for other threads. Returns
+	// false, having popped nothing, if the deque is busy or cannot tell
+	// (the default); otherwise stores the value, or EMPTY, in val.
+	// tid: Thread id, unique across all threads
+	virtual bool try_left_pop_uncontended(int32_t *val,int tid){return false;}
+
+	// right pop that gives up instead of waiting, like
+	// try_left_pop_uncontended.
+	// tid: Thread id, unique across all threads
+	virtual bool try_right_pop_uncontended(int32_t *val,int tid){return false;}
+
+	// left pop that waits for a value while the deque is empty, for at most
+	// timeoutUs microseconds (without limit if negative). Returns EMPTY only
+	// on timeout. The default polls left_pop and yields between tries.
+	// tid: Thread id, unique across all threads
+	virtual int32_t left_pop_wait(int tid,long timeoutUs=-1){
+		return popWaitPolling(false,tid,timeoutUs);
+	}
+
+	// right pop that waits for a value, like left_pop_wait.
+	// tid: Thread id, unique across all threads
+	virtual int32_t right_pop_wait(int tid,long timeoutUs=-1){
+		return popWaitPolling(true,tid,timeoutUs);
+	}
+
 	int32_t remove(int tid){return left_pop(tid);}
 	void insert(int32_t val,int tid){return left_push(val,tid);}
 
+private:
+	int32_t popWaitPolling(bool right,int tid,long timeoutUs){
+		auto deadline=std::chrono::steady_clock::now()+std::chrono::microseconds(timeoutUs);
+		for(;;){
+			int32_t val=right?right_pop(tid):left_pop(tid);
+			if(val!=EMPTY||(timeoutUs>=0&&std::chrono::steady_clock::now()>=deadline)){return val;}
+			std::this_thread::yield();
+		}
+	}
 };
 
+// Base class for deques templated on their element type: they implement
+// RDeque for int32_t elements and are plain Rideables otherwise (e.g. when
+// used with the payloads in PayloadDeque.hpp).
+template<typename T> using RDequeOf = typename std::conditional<std::is_same<T, int32_t>::value, RDeque, Rideable>::type;
+
 #endif
@@ -19,7 +19,15 @@ public:
 	void left_push(T value, int tid);
 	T right_pop(int tid);
 	T left_pop(int tid);
+	T peek_right(int tid);
+	T peek_left(int tid);
+	long size_approx(int tid);
+	bool try_right_push_uncontended(T value, int tid);
+	bool try_left_push_uncontended(T value, int tid);
+	bool try_right_pop_uncontended(T *value, int tid);
+	bool try_left_pop_uncontended(T *value, int tid);
 	inline void lock();
+	inline bool tryLock();
 	inline void unlock();
 private:
 	/* --- Instance Fields --- */
@@ -75,12 +83,89 @@ template<typename T> T SGLDeque<T>::left_pop(int tid) {
 	return value;
 }
 
+template<typename T> T SGLDeque<T>::peek_right(int tid) {
+	T value = m_empty;
+	lock();
+	if (!m_deque.empty()) {
+		value = m_deque.back();
+	}
+	unlock();
+	return value;
+}
+
+template<typename T> T SGLDeque<T>::peek_left(int tid) {
+	T value = m_empty;
+	lock();
+	if (!m_deque.empty()) {
+		value = m_deque.front();
+	}
+	unlock();
+	return value;
+}
+
+template<typename T> long SGLDeque<T>::size_approx(int tid) {
+	lock();
+	long size = m_deque.size();
+	unlock();
+	return size;
+}
+
+// The uncontended variants take the lock only if it is free on the first
+// try, and otherwise leave the deque alone.
+template<typename T> bool SGLDeque<T>::try_right_push_uncontended(T value, int tid) {
+	if (!tryLock()) {
+		return false;
+	}
+	m_deque.push_back(value);
+	unlock();
+	return true;
+}
+
+template<typename T> bool SGLDeque<T>::try_left_push_uncontended(T value, int tid) {
+	if (!tryLock()) {
+		return false;
+	}
+	m_deque.push_front(value);
+	unlock();
+	return true;
+}
+
+template<typename T> bool SGLDeque<T>::try_right_pop_uncontended(T *value, int tid) {
+	if (!tryLock()) {
+		return false;
+	}
+	*value = m_empty;
+	if (!m_deque.empty()) {
+		*value = m_deque.back();
+		m_deque.pop_back();
+	}
+	unlock();
+	return true;
+}
+
+template<typename T> bool SGLDeque<T>::try_left_pop_uncontended(T *value, int tid) {
+	if (!tryLock()) {
+		return false;
+	}
+	*value = m_empty;
+	if (!m_deque.empty()) {
+		*value = m_deque.front();
+		m_deque.pop_front();
+	}
+	unlock();
+	return true;
+}
+
 template<typename T> void SGLDeque<T>::lock() {
 	while (__sync_lock_test_and_set(&m_nLock, 1)) {
 		while (m_nLock);
 	}
 }
 
+template<typename T> bool SGLDeque<T>::tryLock() {
+	return !m_nLock && !__sync_lock_test_and_set(&m_nLock, 1);
+}
+
 template<typename T> void SGLDeque<T>::unlock() {
 	__sync_lock_release(&m_nLock);
 }
@@ -3,11 +3,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <algorithm>
 #include <climits>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include "OFDeque.hpp"
 
 using namespace std;
 
+// A bounded deque (OFDeque -d maxbuffers or -d capacity) makes left_push and
+// right_push wait for pops to make room.  Tests whose threads may all be
+// pushing into a full deque at once would hang, so they reject a deque that
+// might not take the most values they keep in it (LONG_MAX: no limit).
+static void checkCapacity(RDeque* q, const char* test, long most){
+	if (most > q->min_capacity()) {
+		if (most == LONG_MAX) {
+			fprintf(stderr, "%s can fill any bounded deque.\n", test);
+		} else {
+			fprintf(stderr, "%s keeps up to %ld values, but the deque may only take %ld before pushes wait for pops.\n", test, most, q->min_capacity());
+		}
+		errexit("The test cannot drain a full bounded deque; raise -d maxbuffers or -d capacity, or drop them.");
+	}
+}
+
 // PotatoTest methods
 void PotatoTest::init(GlobalTestConfig* gtc){
 	Rideable* ptr = gtc->allocRideable();
@@ -15,6 +37,9 @@ void PotatoTest::init(GlobalTestConfig* gtc){
 	if (!q) {
 		errexit("PotatoTest must be run on RQueue or RDualQueue type object.");
 	}
+	if (dynamic_cast<RDeque*>(ptr)) {
+		checkCapacity(dynamic_cast<RDeque*>(ptr), "PotatoTest", LONG_MAX);
+	}
 	if (gtc->verbose) {
 		cout<<"Running PotatoTest on total container."<<endl;
 	}
@@ -114,6 +139,7 @@ void QueueVerificationTest::init(GlobalTestConfig* gtc) {
 		cout<<"QueueVerificationTest should be run on RDeque type object."<<endl;
 		errexit("QueueVerificationTest must be run on RDeque type object.");
 	}
+	checkCapacity(q, "QueueVerificationTest", LONG_MAX);
 	
 	ug = new UIDGenerator(gtc->task_num);
 	passed.store(1);
@@ -196,6 +222,7 @@ void StackVerificationTest::init(GlobalTestConfig* gtc) {
 		cout<<"StackVerificationTest should be run on RDeque type object."<<endl;
 		errexit("StackVerificationTest must be run on RDeque type object.");
 	}
+	checkCapacity(q, "StackVerificationTest", LONG_MAX);
 
 	gtc->recorder->addThreadField("insOps",&Recorder::sumInts);
 	gtc->recorder->addThreadField("insOps_stddev",&Recorder::stdDevInts);
@@ -297,6 +324,7 @@ void DequeInsertRemoveTest::init(GlobalTestConfig* gtc){
 	if (!q) {
 		 errexit("DequeInsertRemoveTest must be run on RDeque type object.");
 	}
+	checkCapacity(q, "DequeInsertRemoveTest", LONG_MAX);
 
 	std::map<std::string,std::string>::iterator it;
     it = gtc->environment.find("access_type");
@@ -318,6 +346,25 @@ void DequeInsertRemoveTest::init(GlobalTestConfig* gtc){
     	}
     }
 
+	this->batch = 0;
+	it = gtc->environment.find("batch");
+	if (it != gtc->environment.end()) {
+		this->batch = atoi(it->second.c_str());
+		if (this->batch < 0) {
+			errexit("DequeInsertRemoveTest batch size must be positive.");
+		}
+		printf("using batch size: %d\n", this->batch);
+	}
+	gtc->recorder->addGlobalField("batch");
+	gtc->recorder->reportGlobalInfo("batch",this->batch);
+
+	it = gtc->environment.find("cachemisses");
+	this->cacheMisses = it != gtc->environment.end() && it->second == "1";
+	if (this->cacheMisses) {
+		gtc->recorder->addThreadField("l1dMisses_total",&Recorder::sumDoubles);
+		gtc->recorder->addThreadField("llcMisses_total",&Recorder::sumDoubles);
+	}
+
 	gtc->recorder->addThreadField("insOps_total",&Recorder::sumInts);
 	gtc->recorder->addThreadField("insOps_stddev",&Recorder::stdDevInts);
 	gtc->recorder->addThreadField("insOps_each",&Recorder::concat);
@@ -332,6 +379,10 @@ void DequeInsertRemoveTest::init(GlobalTestConfig* gtc){
 }
 
 int DequeInsertRemoveTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	if (this->batch > 0) {
+		return executeBatch(gtc, ltc);
+	}
+
 	struct timeval time_up = gtc->finish;
 	struct timeval now;
 	gettimeofday(&now,NULL);
@@ -342,6 +393,9 @@ int DequeInsertRemoveTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
 	unsigned int r = ltc->seed;
 	int tid = ltc->tid;
 
+	CacheCounters counters;
+	startCacheCounters(counters);
+
 	if (this->type == AccessPattern::QUEUE) {
 		while(now.tv_sec < time_up.tv_sec 
 			|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
@@ -404,10 +458,126 @@ int DequeInsertRemoveTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
 	gtc->recorder->reportThreadInfo("remOpsEmpty_total",remOpsEmpty,ltc->tid);
 	gtc->recorder->reportThreadInfo("remOpsEmpty_stddev",remOpsEmpty,ltc->tid);
 	gtc->recorder->reportThreadInfo("remOpsEmpty_each",remOpsEmpty,ltc->tid);
+	reportCacheCounters(counters,gtc,ltc->tid);
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+
+	return ops;
+}
+
+// Batch mode: every push or pop moves `batch` values with the *_push_n and
+// *_pop_n calls.  Ops are counted per value (a pop_n that comes back short
+// still counts `batch`, like empty single pops do), so the totals compare
+// directly with single operation runs.
+int DequeInsertRemoveTest::executeBatch(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int insOps = 0;
+	int remOps = 0;
+	int remOpsEmpty = 0;
+	unsigned int r = ltc->seed;
+	int tid = ltc->tid;
+	int n = this->batch;
+
+	vector<int32_t> values(n);
+
+	CacheCounters counters;
+	startCacheCounters(counters);
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		r = nextRand(r);
+
+		// QUEUE: push right, pop left; STACK: push and pop right; RANDOM: any side
+		bool push, left;
+		if (this->type == AccessPattern::RANDOM) {
+			push = r%4==0 || r%4==2;
+			left = r%4==0 || r%4==1;
+		} else {
+			push = r%2==0;
+			left = !push && this->type == AccessPattern::QUEUE;
+		}
+
+		if (push) {
+			for (int i = 0; i < n; i++) {
+				values[i] = ops+i+1;
+			}
+			if (left) {
+				q->left_push_n(&values[0],n,tid);
+			} else {
+				q->right_push_n(&values[0],n,tid);
+			}
+			insOps += n;
+		} else {
+			int popped = left ? q->left_pop_n(&values[0],n,tid) : q->right_pop_n(&values[0],n,tid);
+			remOps += n;
+			remOpsEmpty += n - popped;
+		}
+		ops += n;
+		gettimeofday(&now,NULL);
+	}
+
+	gtc->recorder->reportThreadInfo("insOps_total",insOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("insOps_stddev",insOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("insOps_each",insOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOps_total",remOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOps_stddev",remOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOps_each",remOps,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOpsEmpty_total",remOpsEmpty,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOpsEmpty_stddev",remOpsEmpty,ltc->tid);
+	gtc->recorder->reportThreadInfo("remOpsEmpty_each",remOpsEmpty,ltc->tid);
+	reportCacheCounters(counters,gtc,ltc->tid);
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
 
 	return ops;
 }
 
+// Cache miss counters (-d cachemisses=1): one user-space perf_event per
+// thread and cache, read once the thread's timed loop is over.  Machines
+// without the hardware events (most VMs) report 0 after a warning.
+static int openCacheCounter(uint32_t type, uint64_t config){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void DequeInsertRemoveTest::startCacheCounters(CacheCounters& counters){
+	counters.l1d = -1;
+	counters.llc = -1;
+	if (!this->cacheMisses) {
+		return;
+	}
+	counters.l1d = openCacheCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	counters.llc = openCacheCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	if (counters.l1d < 0 || counters.llc < 0) {
+		fprintf(stderr, "warning: cache miss counters unavailable: %s\n", strerror(errno));
+	}
+}
+
+void DequeInsertRemoveTest::reportCacheCounters(CacheCounters& counters, GlobalTestConfig* gtc, int tid){
+	if (!this->cacheMisses) {
+		return;
+	}
+	int fds[2] = { counters.l1d, counters.llc };
+	const char* fields[2] = { "l1dMisses_total", "llcMisses_total" };
+	for (int i = 0; i < 2; i++) {
+		uint64_t count = 0;
+		if (fds[i] >= 0) {
+			if (read(fds[i], &count, sizeof(count)) != sizeof(count)) {
+				count = 0;
+			}
+			close(fds[i]);
+		}
+		gtc->recorder->reportThreadInfo(fields[i],(double)count,tid);
+	}
+}
+
 void DequeInsertRemoveTest::cleanup(GlobalTestConfig* gtc){
 	delete q;
 }
@@ -418,6 +588,7 @@ void DequeLatencyTest::init(GlobalTestConfig* gtc){
 	if (!q) {
 		 errexit("DequeInsertRemoveTest must be run on RDeque type object.");
 	}
+	checkCapacity(q, "DequeLatencyTest", LONG_MAX);
 
 	pthread_barrier_init(&pthread_barrier, NULL, gtc->task_num);
 
@@ -560,3 +731,846 @@ int DequeLatencyTest::innerExec(GlobalTestConfig* gtc, LocalTestConfig* ltc, int
 void DequeLatencyTest::cleanup(GlobalTestConfig* gtc){
 
 }
+
+void OpLatencyTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("OpLatencyTest must be run on RDeque type object.");
+	}
+	checkCapacity(q, "OpLatencyTest", LONG_MAX);
+
+	this->type = AccessPattern::RANDOM;
+	if (gtc->environment.count("access_type")) {
+		const char *str = gtc->environment["access_type"].c_str();
+		if (!strcmp(str, "STACK")) {
+			this->type = AccessPattern::STACK;
+		} else if (!strcmp(str, "QUEUE")) {
+			this->type = AccessPattern::QUEUE;
+		} else if (strcmp(str, "RANDOM")) {
+			printf("unrecognized access pattern - using default access type: RANDOM\n");
+		}
+	}
+
+	this->histograms.assign(gtc->task_num, std::vector<uint64_t>(BucketCount, 0));
+	this->maxima.assign(gtc->task_num, 0);
+
+	gtc->recorder->addGlobalField("lat_p50_ns");
+	gtc->recorder->addGlobalField("lat_p99_ns");
+	gtc->recorder->addGlobalField("lat_p9999_ns");
+	gtc->recorder->addGlobalField("lat_max_ns");
+	this->q->addThreadLogs(gtc->recorder);
+}
+
+// values below 2^SubBits ns get a bucket each, above that every power of two
+// is split into 2^SubBits buckets
+int OpLatencyTest::bucketOf(uint64_t ns){
+	if (ns < (1ull << SubBits)) {
+		return (int)ns;
+	}
+	int log = 63 - __builtin_clzll(ns);
+	int bucket = ((log - SubBits + 1) << SubBits) + (int)((ns >> (log - SubBits)) & ((1 << SubBits) - 1));
+	return bucket < BucketCount ? bucket : BucketCount - 1;
+}
+
+uint64_t OpLatencyTest::bucketValue(int bucket){
+	if (bucket < (1 << SubBits)) {
+		return bucket;
+	}
+	int log = (bucket >> SubBits) + SubBits - 1;
+	return ((1ull << SubBits) | (bucket & ((1 << SubBits) - 1))) << (log - SubBits);
+}
+
+int OpLatencyTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	struct timespec before, after;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	unsigned int r = ltc->seed;
+	int tid = ltc->tid;
+	std::vector<uint64_t>& counts = this->histograms[tid];
+	uint64_t& maximum = this->maxima[tid];
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		r = nextRand(r);
+		int op = (this->type == AccessPattern::RANDOM) ? r%4 : (r%2==0) ? 2 : (this->type == AccessPattern::QUEUE) ? 1 : 3;
+
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if (op == 0) {
+			q->left_push(ops+1,tid);
+		} else if (op == 1) {
+			q->left_pop(tid);
+		} else if (op == 2) {
+			q->right_push(ops+1,tid);
+		} else {
+			q->right_pop(tid);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &after);
+
+		uint64_t ns = (after.tv_sec - before.tv_sec) * 1000000000ull + after.tv_nsec - before.tv_nsec;
+		counts[bucketOf(ns)]++;
+		maximum = ns > maximum ? ns : maximum;
+		ops++;
+		gettimeofday(&now,NULL);
+	}
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+uint64_t OpLatencyTest::percentile(const std::vector<uint64_t>& counts, uint64_t total, double p){
+	uint64_t rank = (uint64_t)(p * total);
+	uint64_t seen = 0;
+	for (int i = 0; i < BucketCount; i++) {
+		seen += counts[i];
+		if (seen > rank) {
+			return bucketValue(i);
+		}
+	}
+	return bucketValue(BucketCount - 1);
+}
+
+void OpLatencyTest::cleanup(GlobalTestConfig* gtc){
+	std::vector<uint64_t> counts(BucketCount, 0);
+	uint64_t total = 0;
+	uint64_t maximum = 0;
+	for (size_t t = 0; t < this->histograms.size(); t++) {
+		for (int i = 0; i < BucketCount; i++) {
+			counts[i] += this->histograms[t][i];
+			total += this->histograms[t][i];
+		}
+		maximum = this->maxima[t] > maximum ? this->maxima[t] : maximum;
+	}
+
+	gtc->recorder->reportGlobalInfo("lat_p50_ns",(unsigned long)percentile(counts, total, 0.5));
+	gtc->recorder->reportGlobalInfo("lat_p99_ns",(unsigned long)percentile(counts, total, 0.99));
+	gtc->recorder->reportGlobalInfo("lat_p9999_ns",(unsigned long)percentile(counts, total, 0.9999));
+	gtc->recorder->reportGlobalInfo("lat_max_ns",(unsigned long)maximum);
+	printf("latency ns: p50 %lu p99 %lu p99.99 %lu max %lu\n", (unsigned long)percentile(counts, total, 0.5),
+		(unsigned long)percentile(counts, total, 0.99), (unsigned long)percentile(counts, total, 0.9999), (unsigned long)maximum);
+
+	delete q;
+}
+
+void ImbalanceTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("ImbalanceTest must be run on RDeque type object.");
+	}
+
+	this->producers = gtc->task_num - 1;
+	if (gtc->environment.count("producers")) {
+		this->producers = atoi(gtc->environment["producers"].c_str());
+	}
+	this->consumerDelay = 1000;
+	if (gtc->environment.count("consumer_delay")) {
+		this->consumerDelay = atoi(gtc->environment["consumer_delay"].c_str());
+	}
+	if (this->producers < 1 || this->producers >= gtc->task_num) {
+		errexit("ImbalanceTest needs at least one producer and one consumer thread.");
+	}
+
+	gtc->recorder->addGlobalField("rss_start_kb");
+	gtc->recorder->addGlobalField("rss_mid_kb");
+	gtc->recorder->addGlobalField("rss_end_kb");
+	gtc->recorder->addGlobalField("rss_peak_kb");
+	this->q->addThreadLogs(gtc->recorder);
+
+	this->runningProducers.store(this->producers);
+	this->stopSampler.store(false);
+	this->sampler = std::thread(&ImbalanceTest::sample, this);
+}
+
+long ImbalanceTest::readRssKB(){
+	long pages = 0;
+	long resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f) {
+		if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+			resident = 0;
+		}
+		fclose(f);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void ImbalanceTest::sample(){
+	while (!this->stopSampler.load()) {
+		Sample s;
+		gettimeofday(&s.time,NULL);
+		s.rssKB = readRssKB();
+		this->samples.push_back(s);
+		usleep(10000);
+	}
+}
+
+int ImbalanceTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int tid = ltc->tid;
+	bool producer = tid < this->producers;
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		if (producer) {
+			q->right_push(ops+1,tid);
+		} else {
+			q->left_pop(tid);
+			for (int i = 0; i < this->consumerDelay; i++) {
+				__builtin_ia32_pause();
+			}
+		}
+		ops++;
+		gettimeofday(&now,NULL);
+	}
+	// a bounded deque blocks producers until there is room, so consumers
+	// keep popping until the last producer is out
+	if (producer) {
+		this->runningProducers.fetch_sub(1);
+	} else {
+		while (this->runningProducers.load() > 0) {
+			q->left_pop(tid);
+		}
+	}
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+void ImbalanceTest::cleanup(GlobalTestConfig* gtc){
+	this->stopSampler.store(true);
+	this->sampler.join();
+
+	// only samples taken while the threads ran
+	long long start = gtc->start.tv_sec * 1000000ll + gtc->start.tv_usec;
+	long long finish = gtc->finish.tv_sec * 1000000ll + gtc->finish.tv_usec;
+	long long mid = (start + finish) / 2;
+	long rssStart = -1, rssMid = -1, rssEnd = -1, rssPeak = 0;
+	for (size_t i = 0; i < this->samples.size(); i++) {
+		long long t = this->samples[i].time.tv_sec * 1000000ll + this->samples[i].time.tv_usec;
+		long rss = this->samples[i].rssKB;
+		if (t < start || t > finish) {
+			continue;
+		}
+		if (rssStart < 0) {
+			rssStart = rss;
+		}
+		if (rssMid < 0 && t >= mid) {
+			rssMid = rss;
+		}
+		rssEnd = rss;
+		rssPeak = rss > rssPeak ? rss : rssPeak;
+	}
+
+	gtc->recorder->reportGlobalInfo("rss_start_kb",(int)rssStart);
+	gtc->recorder->reportGlobalInfo("rss_mid_kb",(int)rssMid);
+	gtc->recorder->reportGlobalInfo("rss_end_kb",(int)rssEnd);
+	gtc->recorder->reportGlobalInfo("rss_peak_kb",(int)rssPeak);
+	printf("rss kB: start %ld mid %ld end %ld peak %ld\n", rssStart, rssMid, rssEnd, rssPeak);
+
+	delete q;
+}
+
+void OscillationTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("OscillationTest must be run on RDeque type object.");
+	}
+
+	this->amplitude = 4;
+	if (gtc->environment.count("amplitude")) {
+		this->amplitude = atoi(gtc->environment["amplitude"].c_str());
+	}
+	if (this->amplitude < 1) {
+		errexit("OscillationTest needs amplitude >= 1.");
+	}
+
+	// the initial OFDeque buffer is split in the middle, so the right side
+	// has bufsize/2 - 1 slots before it appends
+	int bufferSize = 512;
+	if (gtc->environment.count("bufsize") && atoi(gtc->environment["bufsize"].c_str()) > 0) {
+		bufferSize = atoi(gtc->environment["bufsize"].c_str());
+	}
+	int prefill = bufferSize / 2 - 1 - this->amplitude / 2;
+	if (gtc->environment.count("prefill")) {
+		prefill = atoi(gtc->environment["prefill"].c_str());
+	}
+	checkCapacity(q, "OscillationTest", prefill + (long)this->amplitude * gtc->task_num);
+	for (int i = 0; i < prefill; i++) {
+		q->right_push(i+1,0);
+	}
+
+	gtc->recorder->addGlobalField("amplitude");
+	gtc->recorder->reportGlobalInfo("amplitude",this->amplitude);
+	this->q->addThreadLogs(gtc->recorder);
+}
+
+int OscillationTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int tid = ltc->tid;
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		for (int i = 0; i < this->amplitude; i++) {
+			q->right_push(ops+1,tid);
+		}
+		for (int i = 0; i < this->amplitude; i++) {
+			q->right_pop(tid);
+		}
+		ops += 2 * this->amplitude;
+		gettimeofday(&now,NULL);
+	}
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+void OscillationTest::cleanup(GlobalTestConfig* gtc){
+	delete q;
+}
+
+void PeekTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("PeekTest must be run on RDeque type object.");
+	}
+
+	this->producers = gtc->task_num > 1 ? gtc->task_num / 2 : 1;
+	if (gtc->environment.count("producers")) {
+		this->producers = atoi(gtc->environment["producers"].c_str());
+	}
+	if (this->producers < 1 || (gtc->task_num > 1 && this->producers >= gtc->task_num)) {
+		errexit("PeekTest needs at least one producer and one consumer.");
+	}
+	// a single thread only pushes
+	if (gtc->task_num == 1) {
+		checkCapacity(q, "PeekTest", LONG_MAX);
+	}
+
+	if (q->size_approx(0) >= 0) {
+		int bufferSize = 512;
+		if (gtc->environment.count("bufsize") && atoi(gtc->environment["bufsize"].c_str()) > 0) {
+			bufferSize = atoi(gtc->environment["bufsize"].c_str());
+		}
+		// the three chunks must fit a bounded deque
+		if (bufferSize > q->min_capacity() / 3) {
+			bufferSize = q->min_capacity() / 3;
+		}
+		int n = 3 * bufferSize;
+		check(q->peek_left(0) == EMPTY && q->peek_right(0) == EMPTY, "peek on empty", q->peek_left(0), EMPTY);
+		for (int i = 1; i <= n; i++) {
+			q->right_push(i,0);
+		}
+		check(q->peek_left(0) == 1, "peek_left", q->peek_left(0), 1);
+		check(q->peek_right(0) == n, "peek_right", q->peek_right(0), n);
+		check(q->size_approx(0) == n, "size_approx", q->size_approx(0), n);
+		for (int i = 1; i <= bufferSize; i++) {
+			q->left_pop(0);
+			q->right_pop(0);
+		}
+		check(q->peek_left(0) == bufferSize + 1, "peek_left after pops", q->peek_left(0), bufferSize + 1);
+		check(q->peek_right(0) == n - bufferSize, "peek_right after pops", q->peek_right(0), n - bufferSize);
+		check(q->size_approx(0) == n - 2 * bufferSize, "size_approx after pops", q->size_approx(0), n - 2 * bufferSize);
+		while (q->left_pop(0) != EMPTY) { }
+		check(q->peek_left(0) == EMPTY && q->peek_right(0) == EMPTY, "peek after draining", q->peek_right(0), EMPTY);
+		printf("Peek check passed!\n");
+	}
+
+	this->threads = gtc->task_num;
+	this->pushed = new paddedAtomic<long>[gtc->task_num];
+	this->popped = new paddedAtomic<long>[gtc->task_num];
+	for (int i = 0; i < gtc->task_num; i++) {
+		this->pushed[i].ui.store(0);
+		this->popped[i].ui.store(0);
+	}
+
+	gtc->recorder->addThreadField("peeks_total",&Recorder::sumInts);
+	gtc->recorder->addThreadField("emptyPeeks_total",&Recorder::sumInts);
+	gtc->recorder->addThreadField("pops_total",&Recorder::sumInts);
+	this->q->addThreadLogs(gtc->recorder);
+}
+
+void PeekTest::check(bool ok, const char* what, long got, long expected){
+	if (!ok) {
+		fprintf(stderr, "PeekTest: %s returned %ld, expected %ld\n", what, got, expected);
+		errexit("PeekTest failed.");
+	}
+}
+
+long PeekTest::sumCounts(paddedAtomic<long>* counts){
+	long sum = 0;
+	for (int i = 0; i < this->threads; i++) {
+		sum += counts[i].ui.load(std::memory_order_acquire);
+	}
+	return sum;
+}
+
+// a thread's counts trail its operations, so one operation per thread may
+// be in flight; size_approx must be exact up to those
+void PeekTest::checkSize(int tid){
+	long pushedBefore = sumCounts(this->pushed);
+	long poppedBefore = sumCounts(this->popped);
+	long size = q->size_approx(tid);
+	long pushedAfter = sumCounts(this->pushed);
+	long poppedAfter = sumCounts(this->popped);
+	long low = pushedBefore - poppedAfter - (this->threads - this->producers);
+	long high = pushedAfter + this->producers - poppedBefore;
+	check(size >= low, "size_approx (low bound)", size, low);
+	check(size <= high, "size_approx (high bound)", size, high);
+}
+
+int PeekTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int peeks = 0;
+	int emptyPeeks = 0;
+	int pops = 0;
+	int pushes = 0;
+	int tid = ltc->tid;
+	bool producer = tid < this->producers;
+	bool sized = q->size_approx(tid) >= 0;
+	bool ordered = this->producers == 1;
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		if (producer) {
+			q->right_push(++pushes,tid);
+			this->pushed[tid].ui.store(pushes,std::memory_order_release);
+		} else {
+			if (sized && (peeks & 63) == 0) {
+				checkSize(tid);
+			} else {
+				q->size_approx(tid);
+			}
+			peeks++;
+			int32_t peeked = q->peek_left(tid);
+			if (peeked == EMPTY) {
+				emptyPeeks++;
+			} else {
+				int32_t value = q->left_pop(tid);
+				if (value != EMPTY) {
+					// values to the right of the peeked one are larger, and others may have popped it
+					check(!ordered || peeked == PEEK_UNSUPPORTED || value >= peeked, "left_pop after peek_left", value, peeked);
+					pops++;
+					this->popped[tid].ui.store(pops,std::memory_order_release);
+					ops++;
+				}
+			}
+		}
+		ops++;
+		gettimeofday(&now,NULL);
+	}
+
+	gtc->recorder->reportThreadInfo("peeks_total",peeks,ltc->tid);
+	gtc->recorder->reportThreadInfo("emptyPeeks_total",emptyPeeks,ltc->tid);
+	gtc->recorder->reportThreadInfo("pops_total",pops,ltc->tid);
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+void PeekTest::cleanup(GlobalTestConfig* gtc){
+	delete[] this->pushed;
+	delete[] this->popped;
+	delete q;
+}
+
+void WakeTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("WakeTest must be run on RDeque type object.");
+	}
+
+	this->producers = 1;
+	if (gtc->environment.count("producers")) {
+		this->producers = atoi(gtc->environment["producers"].c_str());
+	}
+	if (this->producers < 1 || this->producers >= gtc->task_num) {
+		errexit("WakeTest needs at least one producer and one consumer.");
+	}
+	this->interval = 1000;
+	if (gtc->environment.count("interval_us")) {
+		this->interval = atoi(gtc->environment["interval_us"].c_str());
+	}
+	this->wait = !gtc->environment.count("wait") || gtc->environment["wait"] != "0";
+
+	this->nextValue.store(1);
+	this->sendTimes = std::vector<std::atomic<uint64_t> >(SendRing);
+	this->latencies.assign(gtc->task_num, std::vector<uint64_t>());
+	this->cpuNs.assign(gtc->task_num, 0);
+	this->wallNs.assign(gtc->task_num, 0);
+
+	gtc->recorder->addGlobalField("wake_p50_us");
+	gtc->recorder->addGlobalField("wake_p99_us");
+	gtc->recorder->addGlobalField("wake_max_us");
+	gtc->recorder->addGlobalField("consumer_cpu_pct");
+	this->q->addThreadLogs(gtc->recorder);
+}
+
+uint64_t WakeTest::nowNs(clockid_t clock){
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int WakeTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int tid = ltc->tid;
+	uint64_t cpuStart = nowNs(CLOCK_THREAD_CPUTIME_ID);
+	uint64_t wallStart = nowNs(CLOCK_MONOTONIC);
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		if (tid < this->producers) {
+			int32_t value = this->nextValue.fetch_add(1);
+			this->sendTimes[value % SendRing].store(nowNs(CLOCK_MONOTONIC));
+			q->right_push(value,tid);
+			ops++;
+			usleep(this->interval);
+		} else {
+			int32_t value = this->wait ? q->left_pop_wait(tid,10000) : q->left_pop(tid);
+			if (value != EMPTY) {
+				this->latencies[tid].push_back(nowNs(CLOCK_MONOTONIC) - this->sendTimes[value % SendRing].load());
+				ops++;
+			}
+		}
+		gettimeofday(&now,NULL);
+	}
+
+	this->cpuNs[tid] = nowNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+	this->wallNs[tid] = nowNs(CLOCK_MONOTONIC) - wallStart;
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+void WakeTest::cleanup(GlobalTestConfig* gtc){
+	std::vector<uint64_t> all;
+	uint64_t cpu = 0, wall = 0;
+	for (int t = this->producers; t < gtc->task_num; t++) {
+		all.insert(all.end(), this->latencies[t].begin(), this->latencies[t].end());
+		cpu += this->cpuNs[t];
+		wall += this->wallNs[t];
+	}
+	std::sort(all.begin(), all.end());
+
+	double p50 = all.empty() ? 0 : all[all.size() / 2] / 1000.0;
+	double p99 = all.empty() ? 0 : all[(size_t)(all.size() * 0.99)] / 1000.0;
+	double maximum = all.empty() ? 0 : all.back() / 1000.0;
+	double cpuPct = wall == 0 ? 0 : 100.0 * cpu / wall;
+	gtc->recorder->reportGlobalInfo("wake_p50_us",p50);
+	gtc->recorder->reportGlobalInfo("wake_p99_us",p99);
+	gtc->recorder->reportGlobalInfo("wake_max_us",maximum);
+	gtc->recorder->reportGlobalInfo("consumer_cpu_pct",cpuPct);
+	printf("wake us: p50 %.1f p99 %.1f max %.1f, consumer cpu %.1f%%\n", p50, p99, maximum, cpuPct);
+
+	delete q;
+}
+
+void FanOutTest::init(GlobalTestConfig* gtc){
+	Rideable* ptr = gtc->allocRideable();
+	this->q = dynamic_cast<RDeque*>(ptr);
+	if (!q) {
+		 errexit("FanOutTest must be run on RDeque type object.");
+	}
+	if (gtc->task_num < 2) {
+		errexit("FanOutTest needs a producer and at least one consumer.");
+	}
+
+	this->batch = 8;
+	if (gtc->environment.count("batch")) {
+		this->batch = atoi(gtc->environment["batch"].c_str());
+	}
+	if (this->batch < 1) {
+		errexit("FanOutTest needs batch >= 1.");
+	}
+	this->producerDelay = 0;
+	if (gtc->environment.count("producer_delay")) {
+		this->producerDelay = atoi(gtc->environment["producer_delay"].c_str());
+	}
+	this->pushedSum = 0;
+	this->poppedSum = 0;
+
+	gtc->recorder->addThreadField("pops_total",&Recorder::sumInts);
+	gtc->recorder->addThreadField("emptyPops_total",&Recorder::sumInts);
+	this->q->addThreadLogs(gtc->recorder);
+}
+
+int FanOutTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int pops = 0;
+	int emptyPops = 0;
+	long long sum = 0;
+	int tid = ltc->tid;
+	std::vector<int32_t> values(this->batch);
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		if (tid == 0) {
+			for (int i = 0; i < this->batch; i++) {
+				values[i] = ops + i + 1;
+				sum += values[i];
+			}
+			q->right_push_n(values.data(),this->batch,tid);
+			ops += this->batch;
+			for (int i = 0; i < this->producerDelay; i++) {
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+			}
+		} else {
+			int32_t value = q->right_pop(tid);
+			if (value == EMPTY) {
+				emptyPops++;
+			} else {
+				sum += value;
+				pops++;
+				ops++;
+			}
+		}
+		gettimeofday(&now,NULL);
+	}
+
+	if (tid == 0) {
+		this->pushedSum += sum;
+	} else {
+		this->poppedSum += sum;
+	}
+	gtc->recorder->reportThreadInfo("pops_total",pops,ltc->tid);
+	gtc->recorder->reportThreadInfo("emptyPops_total",emptyPops,ltc->tid);
+	this->q->reportThreadLogs(gtc->recorder,ltc->tid);
+	return ops;
+}
+
+void FanOutTest::cleanup(GlobalTestConfig* gtc){
+	long long drained = 0;
+	for (int32_t value = q->right_pop(0); value != EMPTY; value = q->right_pop(0)) {
+		drained += value;
+	}
+	if (this->poppedSum + drained != this->pushedSum) {
+		errexit("FanOutTest lost or duplicated values.");
+	}
+	delete q;
+}
+
+void BoundedPushTest::init(GlobalTestConfig* gtc){
+	if (gtc->task_num < 2) {
+		errexit("BoundedPushTest needs a producer and a consumer.");
+	}
+	this->producers = gtc->task_num / 2;
+	if (gtc->environment.count("producers")) {
+		this->producers = atoi(gtc->environment["producers"].c_str());
+	}
+	if (this->producers < 1 || this->producers >= gtc->task_num) {
+		errexit("BoundedPushTest needs at least one producer and one consumer.");
+	}
+
+	// FromEnvironment already rejects maxbuffers below the minimum
+	OFDequeOptions options = OFDequeOptions::FromEnvironment(gtc, 8);
+	if (options.m_maxBuffers == 0) {
+		options.m_maxBuffers = OFDequeOptions::MinBuffers;
+	}
+	this->capacity = (long)options.m_maxBuffers * (options.m_sizes.m_max - 2);
+	modelCheck(options);
+	printf("Bounded push check passed!\n");
+
+	this->q = new Deque(EMPTY, gtc->task_num, false, options);
+	this->pushedSum = 0;
+	this->poppedSum = 0;
+	gtc->recorder->addThreadField("fulls_total",&Recorder::sumInts);
+	gtc->recorder->addThreadField("pops_total",&Recorder::sumInts);
+}
+
+void BoundedPushTest::modelCheck(const OFDequeOptions& options){
+	Deque* d = new Deque(EMPTY, 1, false, options);
+	std::deque<int32_t> model;
+	unsigned int r = 1;
+	int32_t next = 1;
+	long fulls = 0;
+
+	for (int round = 0; round < ModelRounds; round++) {
+		// filling rounds push three times in four, draining rounds pop three times in four
+		bool filling = round % 2 == 0;
+		for (long i = 0; i < 4 * this->capacity; i++) {
+			bool push = (rand_r(&r) % 4 != 0) == filling;
+			bool left = rand_r(&r) % 2 == 0;
+			if (push) {
+				OFDequeTypes::PushResult result = left ? d->try_left_push(next, 0) : d->try_right_push(next, 0);
+				if (result == OFDequeTypes::PUSHED) {
+					if (left) {
+						model.push_front(next);
+					} else {
+						model.push_back(next);
+					}
+					next++;
+				} else {
+					fulls++;
+					check(!model.empty(), "push on an empty deque", result, OFDequeTypes::PUSHED);
+					result = left ? d->try_left_push(next, 0) : d->try_right_push(next, 0);
+					check(result == OFDequeTypes::FULL, "push retried after FULL", result, OFDequeTypes::FULL);
+				}
+				check((long)model.size() <= this->capacity, "size", model.size(), this->capacity);
+			} else {
+				int32_t expected = model.empty() ? EMPTY : left ? model.front() : model.back();
+				int32_t value = left ? d->left_pop(0) : d->right_pop(0);
+				check(value == expected, left ? "left_pop" : "right_pop", value, expected);
+				if (!model.empty()) {
+					if (left) {
+						model.pop_front();
+					} else {
+						model.pop_back();
+					}
+				}
+			}
+		}
+	}
+	if (fulls == 0) {
+		errexit("BoundedPushTest: the model check never filled the deque.");
+	}
+	delete d;
+}
+
+void BoundedPushTest::check(bool ok, const char* what, long got, long expected){
+	if (!ok) {
+		fprintf(stderr, "BoundedPushTest: %s returned %ld, expected %ld\n", what, got, expected);
+		errexit("BoundedPushTest failed.");
+	}
+}
+
+int BoundedPushTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	int fulls = 0;
+	int pops = 0;
+	int attempts = 0;
+	long long sum = 0;
+	int tid = ltc->tid;
+	bool producer = tid < this->producers;
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		bool left = (attempts++ & 1) == 0;
+		if (producer) {
+			int32_t value = ops + 1;
+			if ((left ? q->try_left_push(value,tid) : q->try_right_push(value,tid)) == OFDequeTypes::PUSHED) {
+				sum += value;
+				ops++;
+			} else {
+				fulls++;
+				std::this_thread::yield();
+			}
+		} else {
+			int32_t value = left ? q->left_pop(tid) : q->right_pop(tid);
+			if (value != EMPTY) {
+				sum += value;
+				pops++;
+				ops++;
+			}
+		}
+		gettimeofday(&now,NULL);
+	}
+
+	if (producer) {
+		this->pushedSum += sum;
+	} else {
+		this->poppedSum += sum;
+	}
+	gtc->recorder->reportThreadInfo("fulls_total",fulls,ltc->tid);
+	gtc->recorder->reportThreadInfo("pops_total",pops,ltc->tid);
+	return ops;
+}
+
+void BoundedPushTest::cleanup(GlobalTestConfig* gtc){
+	long long drained = 0;
+	long count = 0;
+	for (int32_t value = q->left_pop(0); value != EMPTY; value = q->left_pop(0)) {
+		drained += value;
+		count++;
+	}
+	if (count > this->capacity) {
+		errexit("BoundedPushTest: the deque held more than maxbuffers allow.");
+	}
+	if (this->poppedSum + drained != this->pushedSum) {
+		errexit("BoundedPushTest lost or duplicated values.");
+	}
+	delete q;
+}
+
+void EdgeSearchTest::init(GlobalTestConfig* gtc){
+	this->bufferSize = 8192;
+	if (gtc->environment.count("bufsize")) {
+		this->bufferSize = atoi(gtc->environment["bufsize"].c_str());
+	}
+	this->staleness = 0;
+	if (gtc->environment.count("staleness")) {
+		this->staleness = atoi(gtc->environment["staleness"].c_str());
+	}
+	// the edge sits at 3/4 of the buffer, so the hint must stay inside it
+	if (this->bufferSize < OFDequeBufferSizes::MinSize || abs(this->staleness) >= this->bufferSize / 4) {
+		errexit("EdgeSearchTest needs bufsize >= 8 and |staleness| < bufsize/4.");
+	}
+	gtc->recorder->addGlobalField("staleness");
+	gtc->recorder->reportGlobalInfo("staleness",this->staleness);
+
+	OFDequeOptions options = OFDequeOptions::Defaults(this->bufferSize);
+	options.m_edgeMap = gtc->environment.count("edgemap") && gtc->environment["edgemap"] == "1";
+
+	for (int i = 0; i < gtc->task_num; i++) {
+		Deque* d = new Deque(EMPTY, 1, false, options);
+		for (int j = 1; j <= this->bufferSize / 4; j++) {
+			d->right_push(j, 0);
+		}
+
+		Deque::Buffer* buffer = d->toBuffer(d->m_rightGlobalHint.ui.load().m_buffer);
+		int edge = buffer->m_rightLocalHint.ui.load();
+		buffer->m_rightLocalHint.ui.store(edge - this->staleness);
+
+		// the stale hint must still lead to the real edge
+		Deque::OracleResult result = d->oracle<OFDequeTypes::SIDE_RIGHT>(0);
+		d->m_pReclaimer->clearAll(0);
+		if (result.m_edge.m_pBuffer != buffer || result.m_edge.m_index != edge) {
+			errexit("EdgeSearchTest: oracle did not find the right edge.");
+		}
+		this->deques.push_back(d);
+	}
+}
+
+int EdgeSearchTest::execute(GlobalTestConfig* gtc, LocalTestConfig* ltc){
+	struct timeval time_up = gtc->finish;
+	struct timeval now;
+	gettimeofday(&now,NULL);
+	int ops = 0;
+	Deque* d = this->deques[ltc->tid];
+
+	while(now.tv_sec < time_up.tv_sec 
+		|| (now.tv_sec==time_up.tv_sec && now.tv_usec<time_up.tv_usec) ){
+		// an oracle call is far cheaper than gettimeofday, so check the clock every 256 calls
+		for (int i = 0; i < 256; i++) {
+			d->oracle<OFDequeTypes::SIDE_RIGHT>(0);
+			d->m_pReclaimer->clearAll(0);
+		}
+		ops += 256;
+		gettimeofday(&now,NULL);
+	}
+	return ops;
+}
+
+void EdgeSearchTest::cleanup(GlobalTestConfig* gtc){
+	for (size_t i = 0; i < this->deques.size(); i++) {
+		delete this->deques[i];
+	}
+}
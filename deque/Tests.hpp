@@ -6,8 +6,11 @@
 #endif
 
 #include <atomic>
+#include <thread>
+#include <vector>
 #include "Harness.hpp"
 #include "RDeque.hpp"
+#include "OFDeque.hpp"
 
 class PotatoTest : public Test{
 private:
@@ -59,10 +62,24 @@ public:
 
 	RDeque* q;
 	AccessPattern type;
+	// values per call in batch mode (-d batch=N), 0 for single operations
+	int batch;
+	// count each thread's L1D and last level cache misses (-d cachemisses=1)
+	bool cacheMisses;
 
 	void init(GlobalTestConfig* gtc);
 	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
 	void cleanup(GlobalTestConfig* gtc);
+private:
+	// perf_event descriptors of one thread, -1 where a counter is unavailable
+	struct CacheCounters {
+		int l1d;
+		int llc;
+	};
+
+	int executeBatch(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void startCacheCounters(CacheCounters& counters);
+	void reportCacheCounters(CacheCounters& counters, GlobalTestConfig* gtc, int tid);
 };
 
 class DequeLatencyTest : public Test {
@@ -80,4 +97,210 @@ private:
 	pthread_barrier_t pthread_barrier;
 };
 
+// Per operation latency.  Every thread runs the -d access_type pattern
+// (default RANDOM, i.e. pushes and pops at both ends) and times each call.
+// Latencies go into per thread log-linear histograms (1/64 relative
+// precision), merged in cleanup into the global fields lat_p50_ns,
+// lat_p99_ns, lat_p9999_ns and lat_max_ns.
+class OpLatencyTest : public Test {
+public:
+	enum AccessPattern { QUEUE, STACK, RANDOM };
+
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	static const int SubBits = 6;
+	static const int BucketCount = 64 << SubBits;
+
+	static int bucketOf(uint64_t ns);
+	static uint64_t bucketValue(int bucket);
+	uint64_t percentile(const std::vector<uint64_t>& counts, uint64_t total, double p);
+
+	RDeque* q;
+	AccessPattern type;
+	std::vector<std::vector<uint64_t> > histograms;
+	std::vector<uint64_t> maxima;
+};
+
+// Producer/consumer imbalance.  Threads below -d producers=N (default all
+// but one) right_push as fast as they can, the others left_pop with
+// -d consumer_delay=N pause spins (default 1000) between pops, so the deque
+// keeps growing unless the rideable pushes back (OFDeque -d maxbuffers=N).
+// A sampler thread reads the resident set size every 10 ms; cleanup reports
+// it at the start, middle and end of the run and its peak as the global
+// fields rss_start_kb, rss_mid_kb, rss_end_kb and rss_peak_kb.  Ops are
+// pushes plus pops.
+class ImbalanceTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	struct Sample {
+		struct timeval time;
+		long rssKB;
+	};
+
+	static long readRssKB();
+	void sample();
+
+	RDeque* q;
+	int producers;
+	int consumerDelay;
+	std::atomic<int> runningProducers;
+	std::thread sampler;
+	std::atomic<bool> stopSampler;
+	std::vector<Sample> samples;
+};
+
+// Size oscillation across a buffer boundary.  init pushes -d prefill=N
+// values (default: enough to leave the right edge amplitude/2 slots short
+// of the first append with -d bufsize, default 512), then every thread
+// repeatedly pushes -d amplitude=N values (default 4) on the right and pops
+// them again, so the right end keeps crossing the boundary.  Ops are pushes
+// plus pops; run an OFDeque _Stats rideable to get appends_total,
+// removes_total, retires_total and relinks_total (scripts/oscillation.py
+// turns them into counts per million ops).
+class OscillationTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	RDeque* q;
+	int amplitude;
+};
+
+// Scheduler probes.  init checks peek_left, peek_right and size_approx
+// single-threaded along a run of pushes and pops that crosses several
+// buffers (-d bufsize, default 512, fewer values if the deque is bounded),
+// and fails the run on a wrong answer;
+// deques that keep the RDeque defaults skip the check.  Then threads
+// below -d producers=N (default half, at least one) right_push, and the
+// others behave like a scheduler visiting the deque: size_approx and
+// peek_left first, and a left_pop unless the peek reported EMPTY (deques
+// that return PEEK_UNSUPPORTED are popped every time).  Every 64th probe
+// also checks size_approx against the values the threads have pushed and
+// popped so far, give or take only the operations in flight.  With a single
+// producer values enter in increasing order, so a left_pop must not
+// return less than the peek_left before it.  Ops are pushes, values
+// popped and probes; the thread fields peeks_total, emptyPeeks_total and
+// pops_total count the consumers' work.
+class PeekTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	void check(bool ok, const char* what, long got, long expected);
+	void checkSize(int tid);
+	long sumCounts(paddedAtomic<long>* counts);
+
+	RDeque* q;
+	int producers;
+	int threads;
+	// values each thread has pushed and popped, for checkSize
+	paddedAtomic<long>* pushed;
+	paddedAtomic<long>* popped;
+};
+
+// Idle consumers.  Threads below -d producers=N (default 1) right_push one
+// value every -d interval_us=N microseconds (default 1000) and note when;
+// the others left_pop_wait for values with a 10 ms timeout, or spin on
+// left_pop with -d wait=0.  cleanup reports the time from push to pop as
+// the global fields wake_p50_us, wake_p99_us and wake_max_us, and the CPU
+// time the consumers used as a percentage of their run time as
+// consumer_cpu_pct.  Ops are pushes plus pops.
+class WakeTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	static const int SendRing = 1 << 16;
+	static uint64_t nowNs(clockid_t clock);
+
+	RDeque* q;
+	int producers;
+	int interval;
+	bool wait;
+	std::atomic<int> nextValue;
+	std::vector<std::atomic<uint64_t> > sendTimes;
+	std::vector<std::vector<uint64_t> > latencies;
+	std::vector<uint64_t> cpuNs;
+	std::vector<uint64_t> wallNs;
+};
+
+// Fan-out.  Thread 0 right_push_n's batches of -d batch=N values (default
+// 8), with -d producer_delay=N pause spins (default 0) between batches;
+// all other threads right_pop at the same end.  Ops are values pushed plus
+// values popped; the thread fields pops_total and emptyPops_total count
+// the consumers' pops.  Run it with -d elimbatch=1 to let consumers claim
+// from the producer's batches (batchHandoffs_total with OFDeque _Stats,
+// eliminatedPops_total with the +Elim rideables).  Cleanup drains the deque
+// and exits with an error unless every pushed value came out exactly once
+// (by sum).
+class FanOutTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	RDeque* q;
+	int batch;
+	int producerDelay;
+	std::atomic<long long> pushedSum;
+	std::atomic<long long> poppedSum;
+};
+
+// Bounded pushes.  Runs on its own OFDeque built from the -d options
+// (-r is ignored), with -d bufsize=N defaulting to 8 and -d maxbuffers=N
+// to the minimum of 3.  init checks try_left_push/try_right_push and pops
+// on one thread against a std::deque, with phases that fill the deque to
+// FULL and drain it: a FULL push must change nothing and stay FULL until
+// a pop, the deque never holds more than maxbuffers * (bufsize - 2)
+// values, and a push on an empty deque never gets FULL.  Then threads
+// below -d producers=N (default half) try_push on alternating sides and
+// yield on FULL, and the others pop on alternating sides.  Ops are values
+// pushed plus values popped; the thread fields fulls_total and pops_total
+// count refused pushes and values popped.  Cleanup drains the deque and
+// exits with an error unless every pushed value came out exactly once (by
+// sum).
+class BoundedPushTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	typedef OFDeque<int32_t, false> Deque;
+	static const int ModelRounds = 200;
+
+	void modelCheck(const OFDequeOptions& options);
+	void check(bool ok, const char* what, long got, long expected);
+
+	Deque* q;
+	int producers;
+	long capacity;
+	std::atomic<long long> pushedSum;
+	std::atomic<long long> poppedSum;
+};
+
+// Microbenchmark of the OFDeque edge search.  Every thread gets a private
+// single-buffer OFDeque (-d bufsize=N, default 8192) whose right local hint
+// is -d staleness=N slots behind the right edge (ahead of it if negative),
+// and calls the right side oracle on it in a loop.  Ops are oracle calls.
+class EdgeSearchTest : public Test {
+public:
+	void init(GlobalTestConfig* gtc);
+	int execute(GlobalTestConfig* gtc, LocalTestConfig* ltc);
+	void cleanup(GlobalTestConfig* gtc);
+private:
+	typedef OFDeque<int32_t, false> Deque;
+
+	std::vector<Deque*> deques;
+	int bufferSize;
+	int staleness;
+};
+
 #endif
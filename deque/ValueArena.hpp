@@ -0,0 +1,183 @@
+#ifndef VALUEARENA_HPP
+#define VALUEARENA_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "ConcurrentPrimitives.hpp"
+
+/*
+ * Per-thread arena of fixed-size cells for values too large to live in a
+ * deque slot.  A value is named by a 32-bit handle (owning thread in the top
+ * bits, cell index below), and handle 0 is never handed out so it can stand
+ * for EMPTY.  Cells are carved from large chunks, never returned to malloc,
+ * and recycled through the owner's free list.  A cell released by another
+ * thread goes onto the owner's remote free list (many producers, one
+ * consumer), which the owner drains when its local list runs dry.
+ */
+template<typename T> class ValueArena {
+public:
+	typedef int32_t Handle;
+
+	/* --- Constructors & Destructor --- */
+	ValueArena(int threadCount);
+	~ValueArena();
+
+	/* --- Instance Methods (Interface) --- */
+
+	// construct a value from `value` in the calling thread's arena
+	template<typename U> Handle emplace(U &&value, int tid);
+	// move the value named by `handle` into `outValue` and release its cell
+	void take(Handle handle, T &outValue, int tid);
+	// destroy the value named by `handle` and release its cell
+	void destroy(Handle handle, int tid);
+
+private:
+	/* --- Inner Types --- */
+	struct Cell {
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+		uint32_t m_next;
+	};
+
+	struct ThreadArena {
+		Cell **m_pChunks;
+		uint32_t m_chunkCount;
+		uint32_t m_bump;
+		uint32_t m_freeHead;
+	};
+
+	/* --- Instance Methods (Auxiliary) --- */
+	inline Cell *getCell(Handle handle);
+	inline T *getValue(Handle handle);
+	void release(Handle handle, int tid);
+
+	/* --- Static Fields --- */
+	static const int IndexBits = 24;
+	static const int ChunkBits = 12;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t ChunkMask = (1u << ChunkBits) - 1;
+	static const uint32_t MaxChunks = 1u << (IndexBits - ChunkBits);
+
+	/* --- Instance Fields --- */
+	padded<ThreadArena> *m_pArenas;
+	paddedAtomic<uint32_t> *m_pRemoteFree;
+	const int m_threadCount;
+};
+
+/* ---------------------- */
+/* --- Implementation --- */
+/* ---------------------- */
+
+template<typename T>
+ValueArena<T>::ValueArena(int threadCount) :
+	m_threadCount(threadCount) {
+	assert(threadCount <= (1 << (32 - IndexBits)));
+
+	m_pArenas = new padded<ThreadArena>[threadCount];
+	m_pRemoteFree = new paddedAtomic<uint32_t>[threadCount];
+	for (int i = 0; i < threadCount; i++) {
+		ThreadArena &a = m_pArenas[i].ui;
+		a.m_pChunks = (Cell**)calloc(MaxChunks, sizeof(Cell*));
+		a.m_chunkCount = 0;
+		a.m_bump = 1; // index 0 of every thread is unused, so handle 0 is free for EMPTY
+		a.m_freeHead = 0;
+		m_pRemoteFree[i].ui.store(0, std::memory_order_relaxed);
+	}
+}
+
+template<typename T>
+ValueArena<T>::~ValueArena() {
+	for (int i = 0; i < m_threadCount; i++) {
+		ThreadArena &a = m_pArenas[i].ui;
+		for (uint32_t c = 0; c < a.m_chunkCount; c++) {
+			free(a.m_pChunks[c]);
+		}
+		free(a.m_pChunks);
+	}
+	delete[] m_pArenas;
+	delete[] m_pRemoteFree;
+}
+
+template<typename T>
+template<typename U>
+typename ValueArena<T>::Handle ValueArena<T>::emplace(U &&value, int tid) {
+	ThreadArena &a = m_pArenas[tid].ui;
+
+	uint32_t index = a.m_freeHead;
+	if (index == 0) {
+		index = m_pRemoteFree[tid].ui.exchange(0, std::memory_order_acquire);
+	}
+
+	Handle handle;
+	if (index != 0) {
+		handle = (Handle)(((uint32_t)tid << IndexBits) | index);
+		a.m_freeHead = getCell(handle)->m_next;
+	} else {
+		index = a.m_bump++;
+		assert(index <= IndexMask);
+		if ((index >> ChunkBits) >= a.m_chunkCount) {
+			Cell *chunk = (Cell*)memalign(LEVEL1_DCACHE_LINESIZE, sizeof(Cell) << ChunkBits);
+			assert(chunk);
+			a.m_pChunks[a.m_chunkCount++] = chunk;
+		}
+		handle = (Handle)(((uint32_t)tid << IndexBits) | index);
+	}
+
+	new (getValue(handle)) T(std::forward<U>(value));
+	return handle;
+}
+
+template<typename T>
+void ValueArena<T>::take(Handle handle, T &outValue, int tid) {
+	T *value = getValue(handle);
+	outValue = std::move(*value);
+	value->~T();
+	release(handle, tid);
+}
+
+template<typename T>
+void ValueArena<T>::destroy(Handle handle, int tid) {
+	getValue(handle)->~T();
+	release(handle, tid);
+}
+
+template<typename T>
+typename ValueArena<T>::Cell *ValueArena<T>::getCell(Handle handle) {
+	uint32_t owner = (uint32_t)handle >> IndexBits;
+	uint32_t index = (uint32_t)handle & IndexMask;
+	return &m_pArenas[owner].ui.m_pChunks[index >> ChunkBits][index & ChunkMask];
+}
+
+template<typename T>
+T *ValueArena<T>::getValue(Handle handle) {
+	return reinterpret_cast<T*>(&getCell(handle)->m_storage);
+}
+
+template<typename T>
+void ValueArena<T>::release(Handle handle, int tid) {
+	uint32_t owner = (uint32_t)handle >> IndexBits;
+	uint32_t index = (uint32_t)handle & IndexMask;
+	Cell *cell = getCell(handle);
+
+	if (owner == (uint32_t)tid) {
+		ThreadArena &a = m_pArenas[tid].ui;
+		cell->m_next = a.m_freeHead;
+		a.m_freeHead = index;
+		return;
+	}
+
+	// push-only stack drained wholesale by the owner, so there is no ABA
+	std::atomic<uint32_t> &head = m_pRemoteFree[owner].ui;
+	uint32_t next = head.load(std::memory_order_relaxed);
+	do {
+		cell->m_next = next;
+	} while (!head.compare_exchange_weak(next, index, std::memory_order_release, std::memory_order_relaxed));
+}
+
+#endif
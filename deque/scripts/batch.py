@@ -0,0 +1,18 @@
+#!/usr/bin/python
+# Runs the batch mode of DequeInsertRemoveTest (-d batch=N, values moved per
+# *_push_n/*_pop_n call) for batch sizes 1 to 256.  Batch 0 is the ordinary
+# single operation loop, so the csv shows the items/sec gain directly.
+#
+# Ops are counted per value, one csv per access pattern:
+#   ./data/batch_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK", "RANDOM"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" --meta d:'batch=0':'batch=1':'batch=2':'batch=4':'batch=8':'batch=16':'batch=32':'batch=64':'batch=128':'batch=256' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque_512:OFDeque_4096:OFDeque_512_NoElim:OFDeque_4096_NoElim:SGLDeque -o ./data/batch_"+pattern+".csv"
+	os.system(cmd)
@@ -0,0 +1,20 @@
+#!/usr/bin/python
+# Producer/consumer imbalance (ImbalanceTest, -m 10): all threads but one
+# push, one pops with a delay.  Unbounded, the OFDeque chain and the
+# resident set grow for the whole run; with -d maxbuffers=N producers block
+# once N buffers are linked and rss_start_kb, rss_mid_kb and rss_end_kb
+# stay flat.  The _Stats rideables count the refused pushes as fulls_total.
+#
+# One csv per consumer delay (pause spins per pop):
+#   ./data/bounded_<delay>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for delay in ["100", "1000", "10000"]:
+	cmd = "metacmd.py dq -i 5 -m 10 -d consumer_delay="+delay+" --meta d:'maxbuffers=0':'maxbuffers=4':'maxbuffers=64':'maxbuffers=1024' -v --meta t:2:4:8 --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats -o ./data/bounded_"+delay+".csv"
+	os.system(cmd)
@@ -0,0 +1,18 @@
+#!/usr/bin/python
+# Sweeps the OFDeque buffer size (-d bufsize=N) from 16 to 8192 slots and
+# compares the fixed sizes with the adaptive policy (-d bufsize=adaptive),
+# which lets each side pick its own size between bufmin and bufmax.
+#
+# One csv per access pattern:
+#   ./data/bufsize_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK", "RANDOM"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" --meta d:'bufsize=16':'bufsize=64':'bufsize=256':'bufsize=512':'bufsize=1024':'bufsize=4096':'bufsize=8192':'bufsize=adaptive' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_NoElim -o ./data/bufsize_"+pattern+".csv"
+	os.system(cmd)
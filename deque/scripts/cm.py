@@ -0,0 +1,19 @@
+#!/usr/bin/python
+# Compares the OFDeque contention managers
+# (-d cm=none|exp|polka|spinyield|announce) on DequeInsertRemoveTest.
+# Managers other than none report cmBackoffs_total, cmSpins_total (in
+# 1024s) and cmYields_total, announce also cmAnnounces_total.
+#
+# One csv per access pattern:
+#   ./data/cm_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK", "RANDOM"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" --meta d:'cm=none':'cm=exp':'cm=polka':'cm=spinyield':'cm=announce' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_NoElim -o ./data/cm_"+pattern+".csv"
+	os.system(cmd)
@@ -0,0 +1,18 @@
+#!/usr/bin/python
+# Compares the OFDeque oracle with and without the per-thread edge cache
+# (-d edgecache=1) for the QUEUE and STACK patterns.  The _Stats rideables
+# also report oracleLoops_total and edgeCacheHits_total.
+#
+# One csv per access pattern:
+#   ./data/edgecache_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" --meta d:'edgecache=0':'edgecache=1' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats:OFDeque_NoElim_Stats -o ./data/edgecache_"+pattern+".csv"
+	os.system(cmd)
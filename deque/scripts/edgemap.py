@@ -0,0 +1,25 @@
+#!/usr/bin/python
+# Compares the OFDeque buffer layout with and without per-buffer edge maps
+# (-d edgemap=1) at 512 and 8192 slots per buffer:
+#   - EdgeSearchTest (-m 8): oracle calls against local hint staleness
+#   - DequeInsertRemoveTest (-m 4): mixed pushes and pops; the _Stats
+#     rideables also report edgeMapJumps_total
+#
+# One csv per test and buffer size (both edgemap settings go to the same
+# search csv):
+#   ./data/edgemap_search_<bufsize>.csv
+#   ./data/edgemap_mixed_<bufsize>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for bufsize in ["512", "8192"]:
+	for edgemap in ["0", "1"]:
+		cmd = "metacmd.py dq64 -i 3 -m 8 -r OFDeque_NoElim -t 1 -d bufsize="+bufsize+" -d edgemap="+edgemap+" --meta d:'staleness=0':'staleness=8':'staleness=64':'staleness=100' -v -o ./data/edgemap_search_"+bufsize+".csv"
+		os.system(cmd)
+	cmd = "metacmd.py dq64 -i 3 -m 4 -d bufsize="+bufsize+" --meta d:'edgemap=0':'edgemap=1' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats:OFDeque_NoElim_Stats -o ./data/edgemap_mixed_"+bufsize+".csv"
+	os.system(cmd)
@@ -0,0 +1,23 @@
+#!/usr/bin/python
+# Oracle cost against local hint staleness (EdgeSearchTest, -m 8), for the
+# scalar and AVX2 edge search with 16 byte slots (dq64, dq64v) and 8 byte
+# slots (dq64i, dq64iv).  Ops are oracle calls on a private 8192 slot
+# buffer whose right local hint is -d staleness=N slots behind the edge
+# (ahead of it when negative).
+#
+# Build the binaries first:
+#   make ARCH=64 && make ARCH=64 SIMD=avx2
+#   make ARCH=64 LINKS=index && make ARCH=64 LINKS=index SIMD=avx2
+#
+# Each build writes its own csv, ./data/edgesearch_<binary>.csv.
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for binary in ["dq64", "dq64v", "dq64i", "dq64iv"]:
+	cmd = "metacmd.py "+binary+" -i 3 -m 8 -r OFDeque -t 1 --meta d:'staleness=-2000':'staleness=-512':'staleness=-64':'staleness=-8':'staleness=0':'staleness=8':'staleness=64':'staleness=512':'staleness=2000' -v -o ./data/edgesearch_"+binary+".csv"
+	os.system(cmd)
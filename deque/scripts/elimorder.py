@@ -0,0 +1,32 @@
+#!/usr/bin/python
+# Elimination partner order (-d elimorder=random|near) on the STACK pattern
+# of DequeInsertRemoveTest.  For every distance class (same core complex,
+# same socket, remote) prints the share of table lines read that led to an
+# elimination and the mean time of an elimination try that succeeded.
+#
+# Output:
+#   ./data/elimorder.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+out = "./data/elimorder.csv"
+cmd = "metacmd.py dq -i 3 -m 4 -d access_type=STACK --meta d:'elimorder=random':'elimorder=near' -v --meta t:2:4:8:16:32:64 --meta r:OFDeque_Stats -o "+out
+os.system(cmd)
+
+# per distance class ----------------
+for row in csv.DictReader(open(out)):
+	line = "%s t=%s %s: %s ops" % (row["rideable"], row["threads"], row["environment"], row["ops"])
+	for d in ["Near", "Socket", "Remote"]:
+		lines = float(row["elimLines"+d+"_total"])
+		hits = float(row["elimHits"+d+"_total"])
+		if lines > 0:
+			line += ", %s %.2f%% of %d lines" % (d.lower(), 100 * hits / lines, lines)
+		if hits > 0:
+			line += " in %.0f ns" % (float(row["elimNs"+d+"_total"]) / hits)
+	print line
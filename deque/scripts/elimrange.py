@@ -0,0 +1,32 @@
+#!/usr/bin/python
+# Elimination scan range (-d elimrange=full|adaptive) on the STACK pattern
+# of DequeInsertRemoveTest.  Prints throughput, and from the _Stats
+# rideable the share of elimination tries that paired up and the table
+# lines each try read.
+#
+# Output:
+#   ./data/elimrange.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+out = "./data/elimrange.csv"
+cmd = "metacmd.py dq -i 3 -m 4 -d access_type=STACK --meta d:'elimrange=full':'elimrange=adaptive' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_Stats -o "+out
+os.system(cmd)
+
+# success rate and lines per try ----------------
+for row in csv.DictReader(open(out)):
+	if row["rideable"] != "OFDeque_Stats":
+		print "%s t=%s %s: %s ops" % (row["rideable"], row["threads"], row["environment"], row["ops"])
+		continue
+	tries = float(row["elimTries_total"])
+	if tries == 0:
+		continue
+	eliminated = float(row["elimPushes_total"]) + float(row["elimPops_total"])
+	print "%s t=%s %s: %s ops, %.1f%% of tries eliminated, %.2f lines per try" % (row["rideable"], row["threads"], row["environment"], row["ops"],
+		100 * eliminated / tries, float(row["elimLines_total"]) / tries)
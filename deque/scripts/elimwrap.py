@@ -0,0 +1,18 @@
+#!/usr/bin/python
+# Deques with and without an EliminatingDeque in front of them, on the
+# STACK and RANDOM patterns of DequeInsertRemoveTest.  The +Elim rideables
+# report eliminatedPushes_total and eliminatedPops_total.
+#
+# One csv per access pattern:
+#   ./data/elimwrap_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["STACK", "RANDOM"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" -v --meta t:1...8:12:16:24:32:48:64 --meta r:SGLDeque:SGLDeque+Elim:FCDeque:FCDeque+Elim:OFDeque_NoElim:OFDeque_NoElim+Elim:OFDeque -o ./data/elimwrap_"+pattern+".csv"
+	os.system(cmd)
@@ -0,0 +1,31 @@
+#!/usr/bin/python
+# Fan-out (FanOutTest, -m 14): one producer right_push_n's batches of
+# -d batch=N values and every other thread pops at the right end, with and
+# without batch handoffs (-d elimbatch=1).  Prints pops per second and the
+# share of pops served from the producer's batches.
+#
+# One csv per batch size:
+#   ./data/fanout_<batch>.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for batch in ["4", "8", "16"]:
+	out = "./data/fanout_"+batch+".csv"
+	cmd = "metacmd.py dq -i 3 -m 14 -d batch="+batch+" --meta d:'elimbatch=0':'elimbatch=1' -v --meta t:2:4:8:16 --meta r:OFDeque_Stats:SGLDeque+Elim:FCDeque+Elim -o "+out
+	os.system(cmd)
+
+	# pop rate and handoff share ----------------
+	for row in csv.DictReader(open(out)):
+		pops = float(row["pops_total"])
+		if "batchClaims_total" in row and row["batchClaims_total"]:
+			claims = float(row["batchClaims_total"])
+		else:
+			claims = float(row["eliminatedPops_total"])
+		print "%s t=%s %s: %.0f pops/s, %.1f%% from batches, %s empty pops" % (row["rideable"], row["threads"], row["environment"],
+			pops / float(row["interval"]), 100.0 * claims / pops if pops else 0.0, row["emptyPops_total"])
@@ -0,0 +1,32 @@
+#!/usr/bin/python
+# Local hint sampling (-d hintperiod=P): runs the QUEUE and STACK patterns
+# with the local hints written after every interior operation and after
+# about one in 8 or 64, counting cache misses (-d cachemisses=1).  Prints
+# hint writes and cache misses per op from the _Stats rideables.
+#
+# One csv per access pattern:
+#   ./data/hints_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK"]:
+	out = "./data/hints_"+pattern+".csv"
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" -d cachemisses=1 --meta d:'hintperiod=1':'hintperiod=8':'hintperiod=64' -v --meta t:1:2:4:8:16:32:64 --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats:OFDeque_NoElim_Stats -o "+out
+	os.system(cmd)
+
+	# per op ----------------
+	for row in csv.DictReader(open(out)):
+		ops = float(row["ops"])
+		if ops == 0:
+			continue
+		writes = ""
+		if "hintWrites_total" in row:
+			writes = "hint writes %.3f " % (float(row["hintWrites_total"]) / ops)
+		print "%s t=%s %s: %sL1D misses %.2f LLC misses %.3f per op" % (row["rideable"], row["threads"], row["environment"],
+			writes, float(row["l1dMisses_total"]) / ops, float(row["llcMisses_total"]) / ops)
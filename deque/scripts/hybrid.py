@@ -0,0 +1,31 @@
+#!/usr/bin/python
+# Flat-combining fallback (-d hybrid=1) against both of its parents, OFDeque
+# and FCDeque, on the STACK pattern of DequeInsertRemoveTest from 1 to 128
+# threads.  Prints throughput per thread count; hybrid.R charts it.
+#
+# One csv for all three:
+#   ./data/hybrid.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+out = "./data/hybrid.csv"
+threads = "1...8:12:16:24:32:48:64:96:128"
+os.system("metacmd.py dq -i 3 -m 4 -d access_type=STACK -v --meta t:"+threads+" --meta r:OFDeque:FCDeque -o "+out)
+os.system("metacmd.py dq -i 3 -m 4 -d access_type=STACK -d hybrid=1 -v --meta t:"+threads+" --meta r:OFDeque -o "+out)
+
+# mean throughput ----------------
+runs = {}
+for row in csv.DictReader(open(out)):
+	series = row["rideable"]
+	if "hybrid=1" in row["environment"]:
+		series += " hybrid"
+	runs.setdefault((int(row["threads"]), series), []).append(float(row["ops"]) / float(row["interval"]) / 1e6)
+for (t, series) in sorted(runs):
+	ops = runs[(t, series)]
+	print "t=%d %s: %.2f Mops/s" % (t, series, sum(ops) / len(ops))
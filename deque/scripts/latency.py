@@ -0,0 +1,23 @@
+#!/usr/bin/python
+# Per operation latency (OpLatencyTest, -m 9) of OFDeque with and without
+# the announce contention manager (-d cm=announce, -d cm_announce=K:
+# announce after K failed attempts), at 2x oversubscription.  Reports
+# lat_p50_ns, lat_p99_ns, lat_p9999_ns and lat_max_ns, with cm=announce
+# also cmAnnounces_total and cmBackoffs_total (waits for an announcement).
+#
+# One csv per access pattern:
+#   ./data/latency_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import multiprocessing
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+threads = str(2 * multiprocessing.cpu_count())
+for pattern in ["RANDOM", "QUEUE", "STACK"]:
+	for cm in ["-d cm=none", "-d cm=announce -d cm_announce=1", "-d cm=announce -d cm_announce=4", "-d cm=announce -d cm_announce=16"]:
+		cmd = "metacmd.py dq -i 5 -m 9 -t "+threads+" -d access_type="+pattern+" "+cm+" -v --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats:OFDeque_NoElim_Stats -o ./data/latency_"+pattern+".csv"
+		os.system(cmd)
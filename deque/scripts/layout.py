@@ -0,0 +1,22 @@
+#!/usr/bin/python
+# Packed against striped slot layout (make LAYOUT=striped) on a nearly
+# empty deque: the RANDOM pattern pushes and pops at both ends with equal
+# odds, so the left and right edges stay a few slots apart, on the same
+# cache line unless the slots are striped.
+#
+# Build the binaries first:
+#   make ARCH=64 && make ARCH=64 LAYOUT=striped
+#   make ARCH=64 LINKS=index && make ARCH=64 LINKS=index LAYOUT=striped
+#
+# Each build writes its own csv, ./data/layout_<binary>.csv.
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for binary in ["dq64", "dq64s", "dq64i", "dq64is"]:
+	cmd = "metacmd.py "+binary+" -i 3 -m 4 -d access_type=RANDOM --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque:OFDeque_NoElim -o ./data/layout_"+binary+".csv"
+	os.system(cmd)
@@ -0,0 +1,29 @@
+#!/usr/bin/python
+# Boundary oscillation (OscillationTest, -m 11): every thread pushes and
+# pops -d amplitude=N values at the right end, which sits just short of a
+# buffer boundary, with and without buffer lingering (-d linger=K).  Prints
+# appends, retires and relinks per million ops from the _Stats counters.
+#
+# One csv per amplitude:
+#   ./data/oscillation_<amplitude>.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for amplitude in ["2", "4", "16"]:
+	out = "./data/oscillation_"+amplitude+".csv"
+	cmd = "metacmd.py dq -i 3 -m 11 -d amplitude="+amplitude+" --meta d:'linger=0':'linger=1':'linger=4' -v --meta t:1:2:4:8 --meta r:OFDeque_Stats:OFDeque_NoElim_Stats -o "+out
+	os.system(cmd)
+
+	# per million ops ----------------
+	for row in csv.DictReader(open(out)):
+		ops = float(row["ops"])
+		if ops == 0:
+			continue
+		print "%s t=%s %s: appends %.0f retires %.0f relinks %.0f per Mop" % (row["rideable"], row["threads"], row["environment"],
+			float(row["appends_total"]) * 1e6 / ops, float(row["retires_total"]) * 1e6 / ops, float(row["relinks_total"]) * 1e6 / ops)
@@ -0,0 +1,32 @@
+#!/usr/bin/python
+# Paired slot CAS (-d paircas=1) in the 8 byte slot build: runs the QUEUE
+# and STACK patterns with interior pushes done as two CASes and, where the
+# slots pair up, as one cmpxchg16b.  Prints slot CASes and paired CASes per
+# op from the _Stats rideables.
+#
+# Build the binary first:
+#   make ARCH=64 LINKS=index
+#
+# One csv per access pattern:
+#   ./data/paircas_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK"]:
+	out = "./data/paircas_"+pattern+".csv"
+	cmd = "metacmd.py dq64i -i 3 -m 4 -d access_type="+pattern+" --meta d:'paircas=0':'paircas=1' -v --meta t:1:2:4:8:16:32 --meta r:OFDeque:OFDeque_NoElim:OFDeque_Stats:OFDeque_NoElim_Stats -o "+out
+	os.system(cmd)
+
+	# per op ----------------
+	for row in csv.DictReader(open(out)):
+		ops = float(row["ops"])
+		if ops == 0 or "slotCases_total" not in row:
+			continue
+		print "%s t=%s %s: slot CASes %.3f paired %.3f per op" % (row["rideable"], row["threads"], row["environment"],
+			float(row["slotCases_total"]) / ops, float(row["pairCases_total"]) / ops)
@@ -0,0 +1,26 @@
+#!/usr/bin/python
+# Sweeps payload size (8/32/128 bytes) for the boxed OFDeque against FCDeque
+# and MMDeque on the DequeInsertRemoveTest QUEUE/STACK/RANDOM mixes.  Plain
+# OFDeque_512 and FCDeque (4 byte values) are included as the baseline.
+#
+# MMDeque is only built in the 32-bit binary, so dq runs the full set and
+# dq64 runs everything but MMDeque.  Build the binaries first:
+#   make && make ARCH=64
+#
+# Each build writes its own csv, ./data/payload_<binary>.csv.
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+rideables = {
+	"dq": "OFDeque_512:OFDeque_512_P8:OFDeque_512_P32:OFDeque_512_P128:FCDeque:FCDeque_P8:FCDeque_P32:FCDeque_P128:MMDeque:MMDeque_P8:MMDeque_P32:MMDeque_P128",
+	"dq64": "OFDeque_512:OFDeque_512_P8:OFDeque_512_P32:OFDeque_512_P128:FCDeque:FCDeque_P8:FCDeque_P32:FCDeque_P128",
+}
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for binary in ["dq", "dq64"]:
+	cmd = "metacmd.py "+binary+" -i 3 -m 4 --meta d:'access_type=STACK':'access_type=QUEUE':'access_type=RANDOM' -v --meta t:1...8:12:16:24:32:48:64 --meta r:"+rideables[binary]+" -o ./data/payload_"+binary+".csv"
+	os.system(cmd)
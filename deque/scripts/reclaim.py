@@ -0,0 +1,19 @@
+#!/usr/bin/python
+# Compares OFDeque with hazard pointers (OFDequeHazards, the default) and
+# with epoch based reclamation (OFDequeEpochs).  The _Stats rideables report
+# retiredPeakKB_total, the summed per thread peak of buffers retired but not
+# yet freed.  Small buffers retire most often.
+#
+# One csv per access pattern:
+#   ./data/reclaim_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for pattern in ["QUEUE", "STACK", "RANDOM"]:
+	cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" --meta d:'bufsize=16':'bufsize=512' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque_Stats:OFDeque_Epoch_Stats:OFDeque_NoElim_Stats:OFDeque_NoElim_Epoch_Stats -o ./data/reclaim_"+pattern+".csv"
+	os.system(cmd)
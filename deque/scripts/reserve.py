@@ -0,0 +1,24 @@
+#!/usr/bin/python
+# Runs OFDeque with a reserve of prepared buffers per side (-d reserve=N),
+# refilled by popping threads or by a helper thread (-d reserve_helper=1),
+# against no reserve at all.  Large buffers make the inline initialization
+# that the reserve avoids most visible; the inlineInits_total column of the
+# _Stats rideables counts the appends that still had to do it.
+#
+# One csv per access pattern:
+#   ./data/reserve_<pattern>.csv
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+# metacmd splits meta values on colons, so buffer size and helper setting are
+# outer loops
+for pattern in ["QUEUE", "STACK", "RANDOM"]:
+	for bufsize in ["512", "8192"]:
+		for helper, depths in [("0", "'reserve=0':'reserve=2':'reserve=8'"), ("1", "'reserve=2':'reserve=8'")]:
+			cmd = "metacmd.py dq -i 3 -m 4 -d access_type="+pattern+" -d bufsize="+bufsize+" -d reserve_helper="+helper+" --meta d:"+depths+" -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque_Stats:OFDeque_NoElim_Stats -o ./data/reserve_"+pattern+".csv"
+			os.system(cmd)
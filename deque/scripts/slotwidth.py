@@ -0,0 +1,21 @@
+#!/usr/bin/python
+# Compares OFDeque throughput between the 32-bit build (dq, 8 byte slots,
+# cmpxchg8b), the 64-bit build (dq64, 16 byte slots, cmpxchg16b) and the
+# 64-bit indexed-link build (dq64i, 8 byte slots, 32-bit buffer indices) on
+# the DequeInsertRemoveTest QUEUE/STACK/RANDOM mixes.
+#
+# Build the binaries first:
+#   make && make ARCH=64 && make ARCH=64 LINKS=index
+#
+# Each build writes its own csv, ./data/slotwidth_<binary>.csv.
+from os.path import dirname, realpath, sep, pardir
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for binary in ["dq", "dq64", "dq64i"]:
+	cmd = "metacmd.py "+binary+" -i 3 -m 4 --meta d:'access_type=STACK':'access_type=QUEUE':'access_type=RANDOM' -v --meta t:1...8:12:16:24:32:48:64 --meta r:OFDeque_512:OFDeque_4096:OFDeque_512_NoElim:OFDeque_4096_NoElim -o ./data/slotwidth_"+binary+".csv"
+	os.system(cmd)
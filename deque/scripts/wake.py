@@ -0,0 +1,26 @@
+#!/usr/bin/python
+# Idle consumers (WakeTest, -m 13): one producer pushes a value every
+# -d interval_us=N microseconds and the other threads wait for them, parked
+# in left_pop_wait (-d wait=1) or spinning on left_pop (-d wait=0).  Prints
+# wake-up latency and the CPU the consumers burned.
+#
+# One csv per interval:
+#   ./data/wake_<interval>.csv
+from os.path import dirname, realpath, sep, pardir
+import csv
+import sys
+import os
+
+# execution ----------------
+os.environ['PATH'] = dirname(realpath(__file__))+":" + os.environ['PATH'] # scripts
+os.environ['PATH'] = dirname(realpath(__file__))+"/..:" + os.environ['PATH'] # bin
+os.environ['PATH'] = dirname(realpath(__file__))+"/../../cpp_harness:" + os.environ['PATH'] # metacmd
+for interval in ["100", "1000", "10000"]:
+	out = "./data/wake_"+interval+".csv"
+	cmd = "metacmd.py dq -i 3 -m 13 -d interval_us="+interval+" --meta d:'wait=1':'wait=0' -v --meta t:2:4:8 --meta r:OFDeque:OFDeque_NoElim:SGLDeque -o "+out
+	os.system(cmd)
+
+	# latency and idle cost ----------------
+	for row in csv.DictReader(open(out)):
+		print "%s t=%s %s: wake p50 %s us p99 %s us max %s us, consumer cpu %s%%" % (row["rideable"], row["threads"], row["environment"],
+			row["wake_p50_us"], row["wake_p99_us"], row["wake_max_us"], row["consumer_cpu_pct"])